@@ -59,7 +59,23 @@
  * Locking is done mainly using the adev->sem.
  *
  * The locking rule is: All external entry paths are protected by the
- * sem.
+ * sem. It guards the configuration state and the after-irq jobs.
+ *
+ * The data path doesn't take the sem, so that a slow cmd (scan,
+ * template upload) doesn't stall traffic:
+ *
+ * - adev->cmd_mutex serializes use of the firmware cmd mailbox, see
+ *   acx_issue_cmd_timeout(). It nests inside the sem.
+ *
+ * - adev->tx_lock (acx_tx_lock()) serializes the tx ring producers,
+ *   tx_work and the acx_op_tx() fast path. Tx cleanup runs without
+ *   it, see acx_tx_free().
+ *
+ * - adev->rx_lock (acx_rx_lock()) is held by irq_work while it
+ *   processes the rx ring.
+ *
+ * The rings themselves are only rebuilt with the hw down, after
+ * acx_stop() has cancelled irq_work and tx_work.
  *
  * The adev->spinlock is still kept for the irq top-half, although
  * even there it wouldn't be really required. It's just to not get
@@ -73,6 +89,9 @@
 #define acx_sem_lock(adev)	mutex_lock(&(adev)->mutex)
 #define acx_sem_unlock(adev)	mutex_unlock(&(adev)->mutex)
 
+#define acx_cmd_lock(adev)	mutex_lock(&(adev)->cmd_mutex)
+#define acx_cmd_unlock(adev)	mutex_unlock(&(adev)->cmd_mutex)
+
 /*
  * BOM Logging (Common)
  *
@@ -112,7 +131,7 @@
 
 #define log(chan, args...) \
 	do { \
-		if (acx_debug & (chan)) \
+		if (acx_debug_enabled(chan)) \
 			pr_notice(args);	\
 	} while (0)
 
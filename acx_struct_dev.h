@@ -20,6 +20,8 @@
 
 #include "acx_struct_hw.h"
 #include <linux/wireless.h>
+#include <linux/jump_label.h>
+#include <linux/hrtimer.h>
 #include <net/mac80211.h>
 
 /*
@@ -49,6 +51,29 @@ extern unsigned int acx_debug;
 enum { acx_debug = 0 };
 #endif
 
+/*
+ * Categories logged from slow paths only, on by default
+ * (ACX_DEFAULT_MSG). The others are behind acx_debug_key, which is on
+ * while any of them is set in acx_debug: with them off, a hot path
+ * log() is a nop jump, no load of acx_debug, no formatting.
+ * acx_debug_changed() must follow every acx_debug update.
+ */
+#define ACX_DEBUG_SLOWPATH	(L_INIT | L_ASSOC | L_IOCTL)
+
+#if ACX_DEBUG && LINUX_VERSION_CODE >= KERNEL_VERSION(4, 3, 0)
+DECLARE_STATIC_KEY_FALSE(acx_debug_key);
+void acx_debug_changed(void);
+
+#define acx_debug_enabled(chan) \
+	((((chan) & ~ACX_DEBUG_SLOWPATH) \
+		&& static_branch_unlikely(&acx_debug_key)) \
+	? (acx_debug & (chan)) \
+	: (acx_debug & (chan) & ACX_DEBUG_SLOWPATH))
+#else
+static inline void acx_debug_changed(void) { }
+#define acx_debug_enabled(chan)	(acx_debug & (chan))
+#endif
+
 /* Operations by writing to acx_diag */
 enum {
  	ACX_DIAG_OP_RECALIB,
@@ -58,6 +83,19 @@ enum {
 
 extern unsigned int acx_hwcrypto;
 extern unsigned int acx_watchdog_enable;
+extern unsigned int acx_rx_zerocopy;
+extern unsigned int acx_tx_zerocopy;
+extern unsigned int acx_rx_budget;
+extern unsigned int acx_rx_ring;
+extern unsigned int acx_tx_ring;
+extern unsigned int acx_fw_burst;
+extern unsigned int acx_fw_validate;
+extern unsigned int acx_irq_coalesce;
+#if defined(CONFIG_ACX_MAC80211_SIM)
+extern unsigned int acx_sim_devs;
+extern unsigned int acx_sim_rx_pps;
+extern unsigned int acx_sim_rx_len;
+#endif
 
 /*
  * BOM Constants
@@ -115,6 +153,13 @@ extern unsigned int acx_watchdog_enable;
 
 #define IS_VLYNQ(adev)	((adev)->dev_is_vlynq)
 
+/* Simulated device, see sim.c. Poses as DEVTYPE_PCI */
+#if defined(CONFIG_ACX_MAC80211_SIM)
+ #define IS_SIM(adev)	((adev)->sim != NULL)
+#else
+ #define IS_SIM(adev)	0
+#endif
+
 /* Driver defaults */
 #define DEFAULT_DTIM_INTERVAL	10
 /* used to be 2048, but FreeBSD driver changed it to 4096 to work
@@ -136,25 +181,31 @@ extern unsigned int acx_watchdog_enable;
  * ==================================================
  *
  * This will alloc and use DMAable buffers of
- * WLAN_A4FR_MAXLEN_WEP_FCS * (RX_CNT + TX_CNT) bytes
+ * WLAN_A4FR_MAXLEN_WEP_FCS * (rx_cnt + tx_cnt) bytes
  * RX/TX_CNT=32 -> ~150k DMA buffers
  * RX/TX_CNT=16 -> ~75k DMA buffers
  *
  * 2005-10-10: reduced memory usage by lowering both to 16
+ *
+ * The ring depths are per device now (adev->rx_cnt, tx_cnt), set by
+ * the rxring/txring module params or the ring_size debugfs file.
  */
-#define RX_CNT 16
-#define TX_CNT 16
+#define RX_CNT_DEFAULT 16
+#define TX_CNT_DEFAULT 16
+/* must stay above TX_START_QUEUE, or a stopped queue never restarts */
+#define RING_CNT_MIN 8
+#define RING_CNT_MAX 64
 
 /* we clean up txdescs when we have N free txdesc: */
-#define TX_CLEAN_BACKLOG (TX_CNT/4)
-#define TX_START_CLEAN (TX_CNT - TX_CLEAN_BACKLOG)
+#define TX_CLEAN_BACKLOG(adev) ((adev)->tx_cnt/4)
+#define TX_START_CLEAN(adev) ((adev)->tx_cnt - TX_CLEAN_BACKLOG(adev))
 #define TX_EMERG_CLEAN 2
 /* we stop queue if we have < N free txbufs: */
 #define TX_STOP_QUEUE 3
 /* we start queue if we have >= N free txbufs: */
 #define TX_START_QUEUE 5
 
-#define ACX_TX_QUEUE_MAX_LENGTH 20
+#define ACX_TX_QUEUE_MAX_LENGTH(adev) ((adev)->tx_cnt + 4)
 
 /*
  * BOM Global data
@@ -177,7 +228,8 @@ enum acx_flags {
 	ACX_FLAG_FW_LOADED,
 	ACX_FLAG_HW_UP,
 	ACX_FLAG_SCANNING,
-	ACX_FLAG_WATCHDOG_RUNNING
+	ACX_FLAG_WATCHDOG_RUNNING,
+	ACX_FLAG_RX_POLLING	/* rx irq masked, irq_work keeps polling */
 };
 
 /* MAC mode (BSS type) defines
@@ -199,10 +251,33 @@ enum acx_flags {
 #define ACX_STATUS_3_AUTHENTICATED	3
 #define ACX_STATUS_4_ASSOCIATED		4
 
+struct acxsim;
+
+/*
+ * Tx latency stages, see acx_tx_lat_add(): time spent in adev->tx_queue
+ * up to _acx_tx_data(), in the hw ring up to acx_tx_clean_txdesc(), and
+ * the sum of both. Bucket 0 counts < 1us, bucket n [2^(n-1), 2^n) us,
+ * the last one everything above.
+ */
+enum {
+	ACX_TX_LAT_QUEUE,
+	ACX_TX_LAT_HW,
+	ACX_TX_LAT_TOTAL,
+	ACX_TX_LAT_STAGES
+};
+#define ACX_TX_LAT_BUCKETS	24
+
 struct hw_tx_queue {
+	/* producer side, see acx_tx_free() */
 	unsigned int head;
+	unsigned int queued;
+	/* consumer side */
 	unsigned int tail;
-	unsigned int free;
+	unsigned int cleaned;
+	/* QUEUE is written by the producer, HW and TOTAL by the consumer */
+	unsigned long lat_hist[ACX_TX_LAT_STAGES][ACX_TX_LAT_BUCKETS];
+	/* PCI: hostdescs point into mapped skbs, no bufinfo */
+	int zerocopy;
 
 	struct {
 		struct txacxdesc *start;
@@ -224,6 +299,8 @@ struct hw_tx_queue {
 
 struct hw_rx_queue {
 	unsigned int tail;
+	/* PCI: hostdescs point into mapped skbs instead of bufinfo */
+	int zerocopy;
 
 	struct {
 		struct rxacxdesc *start;
@@ -243,6 +320,23 @@ struct hw_rx_queue {
 	} bufinfo;
 };
 
+/* PCI/MEM EEPROM, also in acx_proc_eeprom_output() */
+#define ACX_EEPROM_SIZE		0x400
+
+/*
+ * Last value of a CONFIGURE IE acked by the fw, see
+ * acx_configure_len(). len == 0: nothing recorded, !valid: the fw was
+ * reset since and doesn't hold it anymore.
+ */
+#define ACX_IE_SHADOW_SLOTS	12
+#define ACX_IE_SHADOW_LEN	16
+
+struct acx_ie_shadow {
+	u8 len;
+	u8 valid;
+	u8 data[ACX_IE_SHADOW_LEN];
+};
+
 /* desc allocation info for both rx,tx hostdesc,desc */
 struct desc_info {
 	union { /* points to PCI-mapped memory */
@@ -278,9 +372,12 @@ struct rx_desc_pair {
 struct acx_device {
 	/* most frequent accesses first (dereferencing and cache line!) */
 
-	/*** Locking ***/
+	/*** Locking, see acx_func.h ***/
 	struct mutex		mutex;
+	struct mutex		cmd_mutex;
 	spinlock_t		spinlock;
+	spinlock_t		tx_lock;
+	spinlock_t		rx_lock;
 
 #ifdef OW_20100613_OBSELETE_ACXLOCK_REMOVE
 #if defined(PARANOID_LOCKING) /* Lock debugging */
@@ -317,6 +414,9 @@ struct acx_device {
 	u8			form_factor;
 	u8			radio_type;
 	u8			eeprom_version;
+	/* copy of the EEPROM, see acx_read_eeprom() */
+	int			eeprom_cached;
+	u8			eeprom[ACX_EEPROM_SIZE];
 
 	struct eeprom_cfg cfgopt;
 
@@ -338,6 +438,33 @@ struct acx_device {
 	struct work_struct irq_work;
 	unsigned int	irq;
 
+	/* Adaptive irq coalescing, see acx_irq_coalesce_update() */
+	struct hrtimer		coalesce_timer;
+	struct {
+		int		active;
+		unsigned long	window_start;
+		unsigned int	window_pkts;
+		unsigned int	last_pps;
+		unsigned long	irqs;
+		unsigned long	timer_polls;
+		unsigned long	bursts;
+	} coalesce;
+
+	/* Last debugfs benchmark run, see bench.c */
+	struct {
+		int		mode;
+		int		status;
+		unsigned int	frames;
+		unsigned int	done;
+		unsigned int	len;
+		unsigned int	depth;
+		u64		ns;
+		u64		cycles;
+		u32		p50;
+		u32		p99;
+		u32		max;
+	} bench;
+
 	struct delayed_work 	watchdog_work;
 	unsigned long 		watchdog_last;
 
@@ -402,6 +529,18 @@ struct acx_device {
 	struct sk_buff_head tx_queue;
 	struct work_struct tx_work;
 
+	/*** Firmware cmds ***/
+	/* HOST_INT_CMD_COMPLETE, completed from irq_work */
+	struct completion	cmd_complete;
+	/* see acx_configure_len() */
+	struct acx_ie_shadow	ie_shadow[ACX_IE_SHADOW_SLOTS];
+
+	/*** Async probe, see acx_probe_async() ***/
+	int			(*probe_finish)(acx_device_t *adev);
+	struct work_struct	probe_work;
+	struct completion	probe_done;
+	int			probe_result;
+
 #ifdef UNUSED
 	int		dup_count;
 	int		nondup_count;
@@ -485,8 +624,9 @@ struct acx_device {
 	struct dentry	*debugfs_dir;
 
 	/* Firmware */
-	firmware_image_t *fw_image;
-	firmware_image_t *radio_image;
+	/* shared, see acx_read_fw() */
+	const firmware_image_t *fw_image;
+	const firmware_image_t *radio_image;
 
 /*************************************************************************
  *** PCI/USB/... must be last or else hw agnostic code breaks horribly ***
@@ -496,10 +636,16 @@ struct acx_device {
 	int acx_txbuf_numblocks;
 	u32 acx_txbuf_free;		/* addr of head of free list */
 	int acx_txbuf_blocks_free;	/* how many are still open */
+	/* host copy of the block link words, see acxmem_init_acx_txbuf() */
+	u32 *acx_txbuf_links;
 	queueindicator_t *acx_queue_indicator;
 #endif
 
 	struct hw_rx_queue hw_rx_queue;
+	/* ring depths in use, and as requested for the next
+	 * acx_create_hostdesc_queues() */
+	unsigned int rx_cnt, tx_cnt;
+	unsigned int rx_cnt_cfg, tx_cnt_cfg;
 	int num_hw_tx_queues;
 	/* pointers to tx buffers, tx host descriptors (in host
 	 * memory) and tx descs in device memory, same for rx */
@@ -526,6 +672,9 @@ struct acx_device {
 #ifdef CONFIG_ACX_MAC80211_MEM
 	struct platform_device	*pdevmem;
 #endif
+#ifdef CONFIG_ACX_MAC80211_SIM
+	struct acxsim		*sim;
+#endif
 
 	unsigned long	membase2;
 	void __iomem	*iobase2;
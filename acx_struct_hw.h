@@ -643,12 +643,15 @@ struct txhostdesc {
 	/* From here on you can use this area as you want (variable length, too!) */
 	u8	*data;
 	struct sk_buff *skb;
+	ktime_t	enqueued;	/* acx_op_tx(), zero if not stamped */
+	ktime_t	submitted;	/* _acx_tx_data() */
 } ACX_PACKED;
 
 struct rxhostdesc {
 	struct hostdesc hd;
 	/* From here on you can use this area as you want (variable length, too!) */
 	rxbuffer_t *data;
+	struct sk_buff *skb;	/* zero-copy rx only, owns data */
 } ACX_PACKED;
 
 #endif /* ACX_PCI */
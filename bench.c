@@ -0,0 +1,669 @@
+/*
+ * Copyright (C) 2003, 2004, 2005, 2006, 2007, 2008, 2012
+ * The ACX100 Open Source Project <acx100-devel@lists.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Packet rate benchmark
+ *
+ * Measures the driver's own per-frame cost by pushing made up frames
+ * through acx_op_tx() or acx_process_rxbuf() as fast as they are
+ * taken. Best run on the simulated device (sim.c), where the "air"
+ * costs nothing, but it works on real hardware as well.
+ *
+ * Driven from debugfs, the write blocks until the run is over:
+ *
+ *   echo "tx [frames [len [depth]]]" > /sys/kernel/debug/acx_mac80211/phyX/bench
+ *   echo "rx [frames [len]]" > ...
+ *   cat .../bench
+ *
+ * tx keeps up to depth frames in flight, latency is taken from
+ * acx_op_tx() to the free of the skb in tx cleanup. rx latency is the
+ * time spent in acx_process_rxbuf(), including mac80211's rx path.
+ * Cycles/frame only count the cycles spent inside those two calls.
+ *
+ *   echo "helpers [iterations]" > ...
+ *
+ * times the pure helpers of the rx/tx/config paths one by one, see
+ * acx_bench_helpers(). Each is checked against known answers first,
+ * and a wrong one is flagged in the results. "make bench" runs the
+ * same checks and timings in userspace, see bench/bench.c.
+ */
+
+#if defined CONFIG_DEBUG_FS && !defined ACX_NO_DEBUG_FILES
+
+#define pr_fmt(fmt) "acx.%s: " fmt, __func__
+
+#include <linux/version.h>
+#include <linux/ktime.h>
+#include <linux/timex.h>
+#include <linux/wait.h>
+#include <linux/sort.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/seq_file.h>
+#include <net/mac80211.h>
+
+#include "acx.h"
+#include "merge.h"
+#include "main.h"
+#include "rx.h"
+#include "tx.h"
+#include "ie.h"
+#include "cardsetting.h"
+#include "bench.h"
+
+#define ACX_BENCH_MAX_FRAMES	(1 << 20)
+#define ACX_BENCH_FRAMES	10000
+#define ACX_BENCH_LEN		1500
+#define ACX_BENCH_LEN_MIN	(WLAN_HDR_A3_LEN + 8)
+#define ACX_BENCH_LEN_MAX	WLAN_A3FR_MAXLEN
+/* give up when no frame completes for this long */
+#define ACX_BENCH_STALL		(2 * HZ)
+#define ACX_BENCH_ITERS		100000
+#define ACX_BENCH_MAX_ITERS	(10 << 20)
+
+enum {
+	ACX_BENCH_NONE,
+	ACX_BENCH_TX,
+	ACX_BENCH_RX,
+	ACX_BENCH_HELPERS,
+};
+
+static const char *const acx_bench_modes[] = {
+	[ACX_BENCH_NONE]	= "none",
+	[ACX_BENCH_TX]		= "tx",
+	[ACX_BENCH_RX]		= "rx",
+	[ACX_BENCH_HELPERS]	= "helpers",
+};
+
+struct acx_bench_run {
+	unsigned int frames;
+	unsigned int submitted;
+	unsigned int done;	/* under acx_bench_lock on tx */
+	u32 *lat;		/* ns, in completion order */
+	u64 cycles;
+	wait_queue_head_t wq;
+};
+
+/*
+ * One run at a time, module wide. The skb destructor has no way back
+ * to the device, it finds the run here.
+ */
+static DEFINE_MUTEX(acx_bench_mutex);
+static DEFINE_SPINLOCK(acx_bench_lock);
+static struct acx_bench_run *acx_bench_cur;
+
+/*
+ * Tags the benchmark's tx skbs (see acx_bench_tx_done()) and records
+ * their latency when tx cleanup frees them. Frames completing after
+ * an aborted run are just freed.
+ */
+void acx_bench_skb_destructor(struct sk_buff *skb)
+{
+	struct acx_bench_run *run;
+	unsigned long flags;
+	s64 ns;
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), skb->tstamp));
+
+	spin_lock_irqsave(&acx_bench_lock, flags);
+	run = acx_bench_cur;
+	if (run && run->done < run->frames) {
+		run->lat[run->done++] = clamp_t(s64, ns, 0, U32_MAX);
+		wake_up(&run->wq);
+	}
+	spin_unlock_irqrestore(&acx_bench_lock, flags);
+}
+
+static unsigned int acx_bench_done(struct acx_bench_run *run)
+{
+	unsigned long flags;
+	unsigned int done;
+
+	spin_lock_irqsave(&acx_bench_lock, flags);
+	done = run->done;
+	spin_unlock_irqrestore(&acx_bench_lock, flags);
+
+	return done;
+}
+
+static void acx_bench_op_tx(acx_device_t *adev, struct sk_buff *skb)
+{
+#if CONFIG_ACX_MAC80211_VERSION < KERNEL_VERSION(3, 7, 0)
+	acx_op_tx(adev->hw, skb);
+#else
+	acx_op_tx(adev->hw, NULL, skb);
+#endif
+}
+
+/* A unicast data frame to our bss, unencrypted, lowest rate, no ack */
+static struct sk_buff *acx_bench_tx_skb(acx_device_t *adev, unsigned int len)
+{
+	struct sk_buff *skb;
+	struct ieee80211_hdr *hdr;
+	struct ieee80211_tx_info *info;
+	int i;
+
+	skb = dev_alloc_skb(len);
+	if (!skb)
+		return NULL;
+
+	hdr = (struct ieee80211_hdr *) skb_put(skb, len);
+	memset(hdr, 0, len);
+	hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA
+		| IEEE80211_STYPE_DATA | IEEE80211_FCTL_TODS);
+	memcpy(hdr->addr1, adev->bssid, ETH_ALEN);
+	memcpy(hdr->addr2, adev->dev_addr, ETH_ALEN);
+	memset(hdr->addr3, 0xff, ETH_ALEN);
+
+	info = IEEE80211_SKB_CB(skb);
+	memset(info, 0, sizeof(*info));
+	info->flags = IEEE80211_TX_CTL_NO_ACK;
+	info->band = adev->rx_status.band;
+	info->control.rates[0].idx = 0;
+	info->control.rates[0].count = 1;
+	for (i = 1; i < IEEE80211_TX_MAX_RATES; i++)
+		info->control.rates[i].idx = -1;
+
+	skb->destructor = acx_bench_skb_destructor;
+
+	return skb;
+}
+
+/* Waits until cond or the run stalls. Returns 0 or a negative error */
+#define acx_bench_wait(run, cond)					\
+({									\
+	unsigned int _last = acx_bench_done(run);			\
+	long _ret;							\
+	int _err = 0;							\
+	while (!(cond)) {						\
+		_ret = wait_event_interruptible_timeout((run)->wq,	\
+			(cond), ACX_BENCH_STALL);			\
+		if (_ret < 0) {						\
+			_err = -EINTR;					\
+			break;						\
+		}							\
+		if (!_ret && acx_bench_done(run) == _last) {		\
+			_err = -ETIMEDOUT;				\
+			break;						\
+		}							\
+		_last = acx_bench_done(run);				\
+	}								\
+	_err;								\
+})
+
+static int acx_bench_tx(acx_device_t *adev, struct acx_bench_run *run,
+			unsigned int len, unsigned int depth)
+{
+	struct sk_buff *skb;
+	cycles_t c0;
+	int res;
+
+	while (run->submitted < run->frames) {
+		res = acx_bench_wait(run,
+			run->submitted - acx_bench_done(run) < depth);
+		if (res)
+			return res;
+
+		skb = acx_bench_tx_skb(adev, len);
+		if (!skb)
+			return -ENOMEM;
+
+		skb->tstamp = ktime_get();
+		c0 = get_cycles();
+		acx_bench_op_tx(adev, skb);
+		run->cycles += get_cycles() - c0;
+		run->submitted++;
+	}
+
+	return acx_bench_wait(run, acx_bench_done(run) == run->frames);
+}
+
+/* The broadcast data frame sim.c injects, see acxsim_build_rxframe() */
+static int acx_bench_rx(acx_device_t *adev, struct acx_bench_run *run,
+			unsigned int len)
+{
+	static const u8 snap[] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00,
+				   0x08, 0x00 };
+	rxbuffer_t *rxbuf;
+	struct ieee80211_hdr *hdr;
+	ktime_t t0;
+	cycles_t c0;
+	int res = 0;
+
+	rxbuf = kzalloc(sizeof(*rxbuf), GFP_KERNEL);
+	if (!rxbuf)
+		return -ENOMEM;
+
+	rxbuf->mac_cnt_rcvd = cpu_to_le16(len + adev->phy_header_len);
+	rxbuf->mac_status = 0x21;
+	rxbuf->phy_level = 60;
+	rxbuf->phy_snr = 40;
+
+	hdr = acx_get_wlan_hdr(adev, rxbuf);
+	hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA
+		| IEEE80211_STYPE_DATA | IEEE80211_FCTL_FROMDS);
+	memset(hdr->addr1, 0xff, ETH_ALEN);
+	memcpy(hdr->addr2, adev->bssid, ETH_ALEN);
+	memcpy(hdr->addr3, adev->bssid, ETH_ALEN);
+	memcpy((u8 *) hdr + WLAN_HDR_A3_LEN, snap, sizeof(snap));
+
+	for (run->done = 0; run->done < run->frames; run->done++) {
+		t0 = ktime_get();
+		c0 = get_cycles();
+		/* irq_work may be in acx_process_rxbuf() meanwhile */
+		acx_rx_lock(adev);
+		acx_process_rxbuf(adev, rxbuf);
+		acx_rx_unlock(adev);
+		run->cycles += get_cycles() - c0;
+		run->lat[run->done] = ktime_to_ns(ktime_sub(ktime_get(), t0));
+
+		if (!(run->done % 1024)) {
+			if (signal_pending(current)) {
+				res = -EINTR;
+				break;
+			}
+			cond_resched();
+		}
+	}
+	run->submitted = run->done;
+
+	kfree(rxbuf);
+	return res;
+}
+
+static int acx_bench_cmp_u32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *) a, y = *(const u32 *) b;
+
+	return (x > y) - (x < y);
+}
+
+static int acx_bench_run(acx_device_t *adev, int mode, unsigned int frames,
+			unsigned int len, unsigned int depth)
+{
+	struct acx_bench_run *run;
+	unsigned long flags;
+	ktime_t start;
+	u64 ns;
+	int res;
+
+	if (!test_bit(ACX_FLAG_HW_UP, &adev->flags))
+		return -ENETDOWN;
+
+	run = kzalloc(sizeof(*run), GFP_KERNEL);
+	if (!run)
+		return -ENOMEM;
+	run->lat = vmalloc(frames * sizeof(*run->lat));
+	if (!run->lat) {
+		kfree(run);
+		return -ENOMEM;
+	}
+	run->frames = frames;
+	init_waitqueue_head(&run->wq);
+
+	mutex_lock(&acx_bench_mutex);
+	spin_lock_irqsave(&acx_bench_lock, flags);
+	acx_bench_cur = run;
+	spin_unlock_irqrestore(&acx_bench_lock, flags);
+
+	log(L_ANY, "bench: %s %u frames of %u bytes, depth %u\n",
+		acx_bench_modes[mode], frames, len, depth);
+
+	start = ktime_get();
+	if (mode == ACX_BENCH_TX)
+		res = acx_bench_tx(adev, run, len, depth);
+	else
+		res = acx_bench_rx(adev, run, len);
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	spin_lock_irqsave(&acx_bench_lock, flags);
+	acx_bench_cur = NULL;
+	spin_unlock_irqrestore(&acx_bench_lock, flags);
+	mutex_unlock(&acx_bench_mutex);
+
+	memset(&adev->bench, 0, sizeof(adev->bench));
+	adev->bench.mode = mode;
+	adev->bench.status = res;
+	adev->bench.frames = frames;
+	adev->bench.done = run->done;
+	adev->bench.len = len;
+	adev->bench.depth = depth;
+	adev->bench.ns = ns;
+	adev->bench.cycles = run->cycles;
+	if (run->done) {
+		sort(run->lat, run->done, sizeof(*run->lat),
+			acx_bench_cmp_u32, NULL);
+		adev->bench.p50 = run->lat[(run->done - 1) * 50 / 100];
+		adev->bench.p99 = run->lat[(run->done - 1) * 99 / 100];
+		adev->bench.max = run->lat[run->done - 1];
+	}
+
+	vfree(run->lat);
+	kfree(run);
+
+	return res;
+}
+
+/*
+ * BOM Helpers
+ * ==================================================
+ */
+
+enum {
+	ACX_BENCH_H_QUALITY,
+	ACX_BENCH_H_PKT_TYPE,
+	ACX_BENCH_H_RATESET,
+	ACX_BENCH_H_RATEINDEX,
+	ACX_BENCH_H_FIND_TIM,
+	ACX_BENCH_H_IE_MAX_LEN,
+	ACX_BENCH_H_NUM,
+};
+
+static const char *const acx_bench_helper_names[] = {
+	[ACX_BENCH_H_QUALITY]	= "acx_signal_determine_quality",
+	[ACX_BENCH_H_PKT_TYPE]	= "acx_get_packet_type_string",
+	[ACX_BENCH_H_RATESET]	= "acx111_tx_build_rateset",
+	[ACX_BENCH_H_RATEINDEX]	= "acx_rate111_hwvalue_to_rateindex",
+	[ACX_BENCH_H_FIND_TIM]	= "acx_beacon_find_tim",
+	[ACX_BENCH_H_IE_MAX_LEN] = "acx_ie_get_max_len",
+};
+BUILD_BUG_DECL(acx_bench_helper_names__VS__enum,
+	ARRAY_SIZE(acx_bench_helper_names) != ACX_BENCH_H_NUM);
+
+/* Last helpers run, module wide, under acx_bench_mutex */
+static struct {
+	u64 ns;
+	u64 cycles;
+	int failed;	/* known answer check, see acx_bench_helpers_check() */
+} acx_bench_helper_res[ACX_BENCH_H_NUM];
+
+/* keeps the results of the timed calls alive */
+static unsigned long acx_bench_sink;
+
+#define acx_bench_loop(h, iters, expr)					\
+do {									\
+	unsigned long _sink = 0;					\
+	ktime_t _t0 = ktime_get();					\
+	cycles_t _c0 = get_cycles();					\
+	for (i = 0; i < (iters); i++)					\
+		_sink += (unsigned long) (expr);			\
+	acx_bench_helper_res[h].cycles = get_cycles() - _c0;		\
+	acx_bench_helper_res[h].ns =					\
+		ktime_to_ns(ktime_sub(ktime_get(), _t0));		\
+	WRITE_ONCE(acx_bench_sink, acx_bench_sink + _sink);		\
+	cond_resched();							\
+} while (0)
+
+/* A beacon as mac80211 hands it to acx_set_beacon(), TIM last */
+static struct sk_buff *acx_bench_beacon(void)
+{
+	static const u8 ies[] = {
+		WLAN_EID_SSID, 9, 'a', 'c', 'x', '-', 'b', 'e', 'n', 'c', 'h',
+		WLAN_EID_SUPP_RATES, 8, 0x82, 0x84, 0x8b, 0x96,
+			0x0c, 0x12, 0x18, 0x24,
+		WLAN_EID_DS_PARAMS, 1, 6,
+		WLAN_EID_TIM, 4, 0, 1, 0, 0,
+	};
+	const size_t hdrlen = offsetof(struct ieee80211_mgmt, u.beacon.variable);
+	struct ieee80211_mgmt *mgmt;
+	struct sk_buff *skb;
+
+	skb = dev_alloc_skb(hdrlen + sizeof(ies));
+	if (!skb)
+		return NULL;
+
+	mgmt = (struct ieee80211_mgmt *) skb_put(skb, hdrlen);
+	memset(mgmt, 0, hdrlen);
+	mgmt->frame_control = cpu_to_le16(IEEE80211_FTYPE_MGMT
+		| IEEE80211_STYPE_BEACON);
+	memcpy(skb_put(skb, sizeof(ies)), ies, sizeof(ies));
+
+	return skb;
+}
+
+/*
+ * Known answers, so a helper made faster but wrong shows up in the
+ * results. info carries rates[0] and rates[1] as best and worst of the
+ * band, and beacon is the one of acx_bench_beacon().
+ */
+static void acx_bench_helpers_check(acx_device_t *adev,
+				struct ieee80211_supported_band *band,
+				struct sk_buff *beacon)
+{
+	const size_t hdrlen = offsetof(struct ieee80211_mgmt, u.beacon.variable);
+	struct ieee80211_tx_info info;
+	int *failed;
+	int h;
+
+	for (h = 0; h < ACX_BENCH_H_NUM; h++)
+		acx_bench_helper_res[h].failed = 0;
+
+	failed = &acx_bench_helper_res[ACX_BENCH_H_QUALITY].failed;
+	*failed |= acx_signal_determine_quality(65, 10) != 55;
+	*failed |= acx_signal_determine_quality(100, 0) != 100;
+	*failed |= acx_signal_determine_quality(30, 25) != 0;
+
+	failed = &acx_bench_helper_res[ACX_BENCH_H_PKT_TYPE].failed;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_MGMT
+			| IEEE80211_STYPE_BEACON), "MGMT/Beacon") != 0;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_CTL
+			| IEEE80211_STYPE_ACK), "CTL/Ack") != 0;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_DATA
+			| IEEE80211_STYPE_NULLFUNC), "DATA/Null") != 0;
+
+	memset(&info, 0, sizeof(info));
+	info.band = adev->rx_status.band;
+	info.control.rates[0].idx = band->n_bitrates - 1;
+	info.control.rates[1].idx = 0;
+	info.control.rates[2].idx = -1;
+	acx_bench_helper_res[ACX_BENCH_H_RATESET].failed =
+		acx111_tx_build_rateset(adev, NULL, &info)
+		!= (band->bitrates[band->n_bitrates - 1].hw_value
+			| band->bitrates[0].hw_value);
+
+	failed = &acx_bench_helper_res[ACX_BENCH_H_RATEINDEX].failed;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_1) != 0;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_54) != 11;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_22) != -1;
+
+	/* SSID, rates and DS params in front of it */
+	acx_bench_helper_res[ACX_BENCH_H_FIND_TIM].failed =
+		acx_beacon_find_tim(beacon) != beacon->data + hdrlen + 24;
+
+	acx_bench_helper_res[ACX_BENCH_H_IE_MAX_LEN].failed =
+		acx_ie_get_max_len()
+		!= acx_ie_descs[ACX111_IE_CONFIG_OPTIONS].len;
+}
+
+/*
+ * Times each helper in a tight loop. Inputs vary with the iteration
+ * where the helper takes any, so no call can be hoisted.
+ */
+static int acx_bench_helpers(acx_device_t *adev, unsigned int iters)
+{
+	struct ieee80211_supported_band *band;
+	struct ieee80211_tx_info info;
+	struct sk_buff *beacon;
+	unsigned int i;
+	int k;
+
+	band = adev->hw->wiphy->bands[adev->rx_status.band];
+	if (!band || !band->n_bitrates)
+		return -ENODEV;
+
+	beacon = acx_bench_beacon();
+	if (!beacon)
+		return -ENOMEM;
+
+	/* a typical rate control answer: 4 rates, best first */
+	memset(&info, 0, sizeof(info));
+	info.band = adev->rx_status.band;
+	for (k = 0; k < IEEE80211_TX_MAX_RATES; k++) {
+		info.control.rates[k].idx = (k < 4)
+			? max(band->n_bitrates - 1 - 2 * k, 0) : -1;
+		info.control.rates[k].count = 2;
+	}
+
+	mutex_lock(&acx_bench_mutex);
+
+	acx_bench_helpers_check(adev, band, beacon);
+
+	acx_bench_loop(ACX_BENCH_H_QUALITY, iters,
+		acx_signal_determine_quality(i & 0x7f, (i >> 7) & 0x1f));
+	acx_bench_loop(ACX_BENCH_H_PKT_TYPE, iters,
+		acx_get_packet_type_string((u16) (i << 2)));
+	acx_bench_loop(ACX_BENCH_H_RATESET, iters,
+		acx111_tx_build_rateset(adev, NULL, &info));
+	acx_bench_loop(ACX_BENCH_H_RATEINDEX, iters,
+		acx_rate111_hwvalue_to_rateindex(1 << (i % 13)));
+	acx_bench_loop(ACX_BENCH_H_FIND_TIM, iters,
+		acx_beacon_find_tim(beacon));
+	acx_bench_loop(ACX_BENCH_H_IE_MAX_LEN, iters,
+		acx_ie_get_max_len());
+
+	mutex_unlock(&acx_bench_mutex);
+
+	dev_kfree_skb(beacon);
+
+	memset(&adev->bench, 0, sizeof(adev->bench));
+	adev->bench.mode = ACX_BENCH_HELPERS;
+	adev->bench.frames = iters;
+	adev->bench.done = iters;
+
+	return 0;
+}
+
+static void acx_bench_show_helpers(struct seq_file *file, acx_device_t *adev)
+{
+	u64 iters = adev->bench.frames;
+	u64 ns100;
+	int h, failed = 0;
+
+	seq_printf(file, "mode: %s\n"
+		"iterations: %u\n",
+		acx_bench_modes[adev->bench.mode], adev->bench.frames);
+
+	mutex_lock(&acx_bench_mutex);
+	for (h = 0; h < ACX_BENCH_H_NUM; h++) {
+		ns100 = div64_u64(acx_bench_helper_res[h].ns * 100, iters);
+		seq_printf(file, "%s: %llu.%02llu ns/call, %llu cycles/call%s\n",
+			acx_bench_helper_names[h],
+			div_u64(ns100, 100), ns100 % 100,
+			div64_u64(acx_bench_helper_res[h].cycles, iters),
+			acx_bench_helper_res[h].failed
+			? ", known answer FAILED" : "");
+		failed += acx_bench_helper_res[h].failed;
+	}
+	mutex_unlock(&acx_bench_mutex);
+
+	seq_printf(file, "known answers: %s\n", failed ? "FAILED" : "ok");
+}
+
+int acx_bench_show(struct seq_file *file, acx_device_t *adev)
+{
+	u64 done = adev->bench.done;
+
+	if (adev->bench.mode == ACX_BENCH_NONE) {
+		seq_printf(file, "no run yet, write "
+			"\"tx [frames [len [depth]]]\", "
+			"\"rx [frames [len]]\" or "
+			"\"helpers [iterations]\"\n");
+		return 0;
+	}
+	if (adev->bench.mode == ACX_BENCH_HELPERS) {
+		acx_bench_show_helpers(file, adev);
+		return 0;
+	}
+
+	seq_printf(file, "mode: %s\n"
+		"status: %d\n"
+		"frames: %u/%u\n"
+		"len: %u\n",
+		acx_bench_modes[adev->bench.mode], adev->bench.status,
+		adev->bench.done, adev->bench.frames, adev->bench.len);
+	if (adev->bench.mode == ACX_BENCH_TX)
+		seq_printf(file, "depth: %u\n", adev->bench.depth);
+
+	seq_printf(file, "time: %llu us\n"
+		"pps: %llu\n"
+		"cycles/frame: %llu\n"
+		"latency p50: %u ns\n"
+		"latency p99: %u ns\n"
+		"latency max: %u ns\n",
+		div_u64(adev->bench.ns, NSEC_PER_USEC),
+		adev->bench.ns ?
+			div64_u64(done * NSEC_PER_SEC, adev->bench.ns) : 0,
+		done ? div64_u64(adev->bench.cycles, done) : 0,
+		adev->bench.p50, adev->bench.p99, adev->bench.max);
+
+	return 0;
+}
+
+ssize_t acx_bench_write(acx_device_t *adev, struct file *file,
+			const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	char buf[64], mode_str[8];
+	unsigned int frames = ACX_BENCH_FRAMES;
+	unsigned int len = ACX_BENCH_LEN;
+	unsigned int depth = adev->tx_cnt;
+	size_t buflen;
+	int args, mode, res;
+
+	buflen = min(count, sizeof(buf) - 1);
+	if (unlikely(copy_from_user(buf, ubuf, buflen)))
+		return -EFAULT;
+	buf[buflen] = '\0';
+
+	args = sscanf(buf, "%7s %u %u %u", mode_str, &frames, &len, &depth);
+	if (args < 1)
+		return -EINVAL;
+
+	if (!strcmp(mode_str, "tx"))
+		mode = ACX_BENCH_TX;
+	else if (!strcmp(mode_str, "rx"))
+		mode = ACX_BENCH_RX;
+	else if (!strcmp(mode_str, "helpers"))
+		mode = ACX_BENCH_HELPERS;
+	else
+		return -EINVAL;
+
+	if (mode == ACX_BENCH_HELPERS) {
+		/* first number is the iteration count */
+		if (args < 2)
+			frames = ACX_BENCH_ITERS;
+		if (frames < 1 || frames > ACX_BENCH_MAX_ITERS)
+			return -EINVAL;
+		res = acx_bench_helpers(adev, frames);
+		return res ? res : count;
+	}
+
+	if (frames < 1 || frames > ACX_BENCH_MAX_FRAMES
+		|| len < ACX_BENCH_LEN_MIN || len > ACX_BENCH_LEN_MAX)
+		return -EINVAL;
+	/* the ring plus what acx_op_tx() queues for tx_work */
+	depth = clamp_t(unsigned int, depth, 1,
+			adev->tx_cnt + ACX_TX_QUEUE_MAX_LENGTH(adev));
+
+	res = acx_bench_run(adev, mode, frames, len, depth);
+	if (res)
+		return res;
+
+	return count;
+}
+
+#endif /* CONFIG_DEBUG_FS && ! ACX_NO_DEBUG_FILES */
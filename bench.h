@@ -0,0 +1,37 @@
+#ifndef _ACX_BENCH_H_
+#define _ACX_BENCH_H_
+
+/* Packet rate benchmark, driven through debugfs, see bench.c */
+
+#if defined CONFIG_DEBUG_FS && !defined ACX_NO_DEBUG_FILES
+
+struct seq_file;
+struct file;
+
+int acx_bench_show(struct seq_file *file, acx_device_t *adev);
+ssize_t acx_bench_write(acx_device_t *adev, struct file *file,
+			const char __user *ubuf, size_t count, loff_t *ppos);
+
+void acx_bench_skb_destructor(struct sk_buff *skb);
+
+/*
+ * Tx completion of a frame made up by the benchmark: it never came
+ * from mac80211, so it must not go back there. Returns 1 if the skb
+ * was taken.
+ */
+static inline int acx_bench_tx_done(struct sk_buff *skb)
+{
+	if (likely(skb->destructor != acx_bench_skb_destructor))
+		return 0;
+
+	dev_kfree_skb_any(skb);
+	return 1;
+}
+
+#else
+
+static inline int acx_bench_tx_done(struct sk_buff *skb) { return 0; }
+
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2003, 2004, 2005, 2006, 2007, 2008, 2012
+ * The ACX100 Open Source Project <acx100-devel@lists.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Userspace helper bench
+ *
+ * Builds the pure helpers of the rx/tx/config paths out of the driver
+ * sources against shim/acx_shim.h, checks them against known answers
+ * and times them, without a kernel or a card:
+ *
+ *   make bench [BENCH_ITERS=n]
+ *
+ * ie.c is compiled as it is, the other helpers are cut out of their
+ * files by extract.awk. Exits nonzero if a known answer is wrong, so
+ * it can run in CI. The in-kernel counterpart is the "helpers" mode
+ * of the debugfs bench, see ../bench.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ie.h"
+
+/* the helpers, see extract.awk */
+u8 acx_signal_determine_quality(u8 signal, u8 noise);
+const char *acx_get_packet_type_string(u16 fc);
+u16 acx111_tx_build_rateset(acx_device_t *adev, txacxdesc_t *txdesc,
+			struct ieee80211_tx_info *info);
+int acx_rate111_hwvalue_to_rateindex(u16 hw_value);
+u8 *acx_beacon_find_tim(struct sk_buff *beacon_skb);
+extern struct ieee80211_rate acx111_rates[];
+extern const int acx111_rates_sizeof;
+
+enum {
+	BENCH_QUALITY,
+	BENCH_PKT_TYPE,
+	BENCH_RATESET,
+	BENCH_RATEINDEX,
+	BENCH_FIND_TIM,
+	BENCH_IE_MAX_LEN,
+	BENCH_NUM,
+};
+
+static const char *const bench_names[] = {
+	[BENCH_QUALITY]		= "acx_signal_determine_quality",
+	[BENCH_PKT_TYPE]	= "acx_get_packet_type_string",
+	[BENCH_RATESET]		= "acx111_tx_build_rateset",
+	[BENCH_RATEINDEX]	= "acx_rate111_hwvalue_to_rateindex",
+	[BENCH_FIND_TIM]	= "acx_beacon_find_tim",
+	[BENCH_IE_MAX_LEN]	= "acx_ie_get_max_len",
+};
+
+static struct {
+	u64 ns;
+	int failed;
+} bench_res[BENCH_NUM];
+
+/* keeps the results of the timed calls alive */
+static volatile unsigned long bench_sink;
+
+static u64 bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#define bench_loop(h, iters, expr)					\
+do {									\
+	unsigned long _sink = 0;					\
+	u64 _t0 = bench_now();						\
+	for (i = 0; i < (iters); i++)					\
+		_sink += (unsigned long) (expr);			\
+	bench_res[h].ns = bench_now() - _t0;				\
+	bench_sink += _sink;						\
+} while (0)
+
+/* The device of an acx111: just the 2.4GHz band */
+static struct ieee80211_supported_band bench_band;
+static struct wiphy bench_wiphy;
+static struct ieee80211_hw bench_hw;
+static struct acx_device bench_adev;
+
+/* A beacon as mac80211 hands it to acx_set_beacon(), TIM last */
+static u8 bench_beacon_data[] = {
+	/* frame_control: beacon */
+	0x80, 0x00,
+	[offsetof(struct ieee80211_mgmt, u.beacon.variable)] =
+	WLAN_EID_SSID, 9, 'a', 'c', 'x', '-', 'b', 'e', 'n', 'c', 'h',
+	WLAN_EID_SUPP_RATES, 8, 0x82, 0x84, 0x8b, 0x96,
+		0x0c, 0x12, 0x18, 0x24,
+	WLAN_EID_DS_PARAMS, 1, 6,
+	WLAN_EID_TIM, 4, 0, 1, 0, 0,
+};
+static struct sk_buff bench_beacon = {
+	.data = bench_beacon_data,
+	.len = sizeof(bench_beacon_data),
+};
+
+/* Same known answers as acx_bench_helpers_check() in ../bench.c */
+static void bench_check(void)
+{
+	const size_t hdrlen = offsetof(struct ieee80211_mgmt, u.beacon.variable);
+	struct ieee80211_supported_band *band = &bench_band;
+	struct ieee80211_tx_info info;
+	int *failed;
+
+	failed = &bench_res[BENCH_QUALITY].failed;
+	*failed |= acx_signal_determine_quality(65, 10) != 55;
+	*failed |= acx_signal_determine_quality(100, 0) != 100;
+	*failed |= acx_signal_determine_quality(30, 25) != 0;
+
+	failed = &bench_res[BENCH_PKT_TYPE].failed;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_MGMT
+			| IEEE80211_STYPE_BEACON), "MGMT/Beacon") != 0;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_CTL
+			| IEEE80211_STYPE_ACK), "CTL/Ack") != 0;
+	*failed |= strcmp(acx_get_packet_type_string(IEEE80211_FTYPE_DATA
+			| IEEE80211_STYPE_NULLFUNC), "DATA/Null") != 0;
+
+	memset(&info, 0, sizeof(info));
+	info.band = NL80211_BAND_2GHZ;
+	info.control.rates[0].idx = band->n_bitrates - 1;
+	info.control.rates[1].idx = 0;
+	info.control.rates[2].idx = -1;
+	bench_res[BENCH_RATESET].failed =
+		acx111_tx_build_rateset(&bench_adev, NULL, &info)
+		!= (RATE111_54 | RATE111_1);
+
+	failed = &bench_res[BENCH_RATEINDEX].failed;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_1) != 0;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_54) != 11;
+	*failed |= acx_rate111_hwvalue_to_rateindex(RATE111_22) != -1;
+
+	/* SSID, rates and DS params in front of it */
+	bench_res[BENCH_FIND_TIM].failed =
+		acx_beacon_find_tim(&bench_beacon)
+		!= bench_beacon.data + hdrlen + 24;
+
+	bench_res[BENCH_IE_MAX_LEN].failed =
+		acx_ie_get_max_len()
+		!= acx_ie_descs[ACX111_IE_CONFIG_OPTIONS].len;
+}
+
+int main(int argc, char **argv)
+{
+	struct ieee80211_tx_info info;
+	unsigned long iters = 1000000;
+	unsigned long i;
+	int h, k, failed = 0;
+
+	if (argc > 1)
+		iters = strtoul(argv[1], NULL, 0);
+	if (!iters)
+		iters = 1;
+
+	bench_band.bitrates = acx111_rates;
+	bench_band.n_bitrates = acx111_rates_sizeof;
+	bench_wiphy.bands[NL80211_BAND_2GHZ] = &bench_band;
+	bench_hw.wiphy = &bench_wiphy;
+	bench_adev.hw = &bench_hw;
+
+	bench_check();
+
+	/* a typical rate control answer: 4 rates, best first */
+	memset(&info, 0, sizeof(info));
+	info.band = NL80211_BAND_2GHZ;
+	for (k = 0; k < IEEE80211_TX_MAX_RATES; k++) {
+		info.control.rates[k].idx = (k < 4)
+			? max(bench_band.n_bitrates - 1 - 2 * k, 0) : -1;
+		info.control.rates[k].count = 2;
+	}
+
+	/* Inputs vary with the iteration where the helper takes any, as
+	 * in acx_bench_helpers() */
+	bench_loop(BENCH_QUALITY, iters,
+		acx_signal_determine_quality(i & 0x7f, (i >> 7) & 0x1f));
+	bench_loop(BENCH_PKT_TYPE, iters,
+		acx_get_packet_type_string((u16) (i << 2)));
+	bench_loop(BENCH_RATESET, iters,
+		acx111_tx_build_rateset(&bench_adev, NULL, &info));
+	bench_loop(BENCH_RATEINDEX, iters,
+		acx_rate111_hwvalue_to_rateindex(1 << (i % 13)));
+	bench_loop(BENCH_FIND_TIM, iters,
+		acx_beacon_find_tim(&bench_beacon));
+	bench_loop(BENCH_IE_MAX_LEN, iters,
+		acx_ie_get_max_len());
+
+	printf("iterations: %lu\n", iters);
+	for (h = 0; h < BENCH_NUM; h++) {
+		printf("%s: %.2f ns/call%s\n", bench_names[h],
+			(double) bench_res[h].ns / iters,
+			bench_res[h].failed ? ", known answer FAILED" : "");
+		failed += bench_res[h].failed;
+	}
+	printf("known answers: %s\n", failed ? "FAILED" : "ok");
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
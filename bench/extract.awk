@@ -0,0 +1,39 @@
+# Prints the top level definitions of the functions and variables named
+# in syms (space separated) from the C files given, for the userspace
+# helper bench. A definition runs from its first line to the next "}"
+# or "};" in column 0; a one line variable definition is just that line.
+
+BEGIN {
+	n = split(syms, s, " ")
+	for (i = 1; i <= n; i++)
+		want[s[i]] = 1
+}
+
+on {
+	print
+	if (/^}/)
+		on = 0
+	next
+}
+
+/^[A-Za-z_]/ && (!/\);[ \t]*$/ || /=/) {
+	if (!match($0, /[A-Za-z_][A-Za-z_0-9]*[ \t]*[([=]/))
+		next
+	name = substr($0, RSTART, RLENGTH - 1)
+	sub(/[ \t]+$/, "", name)
+	if (!(name in want))
+		next
+	printf("#line %d \"%s\"\n", FNR, FILENAME)
+	print
+	found[name] = 1
+	if (!/;[ \t]*$/)
+		on = 1
+}
+
+END {
+	for (name in want)
+		if (!(name in found)) {
+			printf("extract.awk: %s not found\n", name) > "/dev/stderr"
+			exit 1
+		}
+}
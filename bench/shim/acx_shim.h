@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2003, 2004, 2005, 2006, 2007, 2008, 2012
+ * The ACX100 Open Source Project <acx100-devel@lists.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Kernel API shim for the userspace helper bench, see bench/bench.c
+ *
+ * Just the types, macros and mac80211/skb stand-ins the benched
+ * helpers and acx_struct_hw.h touch, nothing more. Force-included
+ * into every file of the bench build; acx_struct_hw.h reaches it again
+ * through shim/linux/ieee80211.h.
+ */
+
+#ifndef _ACX_SHIM_H_
+#define _ACX_SHIM_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+#include <linux/types.h>
+
+/* Types */
+typedef __u8 u8;
+typedef __u16 u16;
+typedef __u32 u32;
+typedef __u64 u64;
+typedef __s8 s8;
+typedef __s16 s16;
+typedef __s32 s32;
+
+#define cpu_to_le16(x)	htole16(x)
+#define le16_to_cpu(x)	le16toh(x)
+#define cpu_to_le32(x)	htole32(x)
+#define le32_to_cpu(x)	le32toh(x)
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define min(a, b)	((a) < (b) ? (a) : (b))
+#define max(a, b)	((a) > (b) ? (a) : (b))
+#define BUG_ON(c)	((void) 0)
+
+#define ACX_DEBUG	1
+
+/* Skip acx.h, which ie.h includes: it pulls in the whole driver */
+#define _ACX_H_
+#include "acx_struct_hw.h"
+
+/* Logging, see acx_debug.h: all off */
+#define acx_debug_enabled(level)	0
+#define logf0(chan, msg)		do { } while (0)
+#define logf1(chan, msg, ...)		do { } while (0)
+
+/* struct sk_buff */
+struct sk_buff {
+	u8 *data;
+	unsigned int len;
+};
+
+/* mac80211 */
+enum nl80211_band {
+	NL80211_BAND_2GHZ,
+	NL80211_BAND_5GHZ,
+	NUM_NL80211_BANDS,
+};
+
+struct ieee80211_rate {
+	u32 flags;
+	u16 bitrate;
+	u16 hw_value, hw_value_short;
+};
+
+struct ieee80211_supported_band {
+	struct ieee80211_rate *bitrates;
+	int n_bitrates;
+};
+
+struct wiphy {
+	struct ieee80211_supported_band *bands[NUM_NL80211_BANDS];
+};
+
+struct ieee80211_hw {
+	struct wiphy *wiphy;
+};
+
+#define IEEE80211_TX_MAX_RATES	4
+
+struct ieee80211_tx_rate {
+	s8 idx;
+	u8 count;
+};
+
+struct ieee80211_tx_info {
+	u8 band;
+	struct {
+		struct ieee80211_tx_rate rates[IEEE80211_TX_MAX_RATES];
+	} control;
+};
+
+/* The part of the device the helpers look at */
+struct acx_device {
+	struct ieee80211_hw *hw;
+};
+
+#endif /* _ACX_SHIM_H_ */
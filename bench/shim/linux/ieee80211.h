@@ -0,0 +1,53 @@
+/*
+ * Userspace stand-in for <linux/ieee80211.h>, see bench/shim/acx_shim.h
+ */
+
+#ifndef _ACX_SHIM_IEEE80211_H_
+#define _ACX_SHIM_IEEE80211_H_
+
+#include <linux/if_ether.h>
+
+#define IEEE80211_FCTL_FTYPE		0x000c
+#define IEEE80211_FCTL_STYPE		0x00f0
+
+#define IEEE80211_FTYPE_MGMT		0x0000
+#define IEEE80211_FTYPE_CTL		0x0004
+#define IEEE80211_FTYPE_DATA		0x0008
+
+#define IEEE80211_STYPE_BEACON		0x0080
+#define IEEE80211_STYPE_ACK		0x00D0
+#define IEEE80211_STYPE_NULLFUNC	0x0040
+
+#define WLAN_EID_SSID			0
+#define WLAN_EID_SUPP_RATES		1
+#define WLAN_EID_DS_PARAMS		3
+#define WLAN_EID_TIM			5
+
+struct ieee80211_hdr {
+	__le16 frame_control;
+	__le16 duration_id;
+	u8 addr1[ETH_ALEN];
+	u8 addr2[ETH_ALEN];
+	u8 addr3[ETH_ALEN];
+	__le16 seq_ctrl;
+	u8 addr4[ETH_ALEN];
+} __attribute__ ((packed));
+
+struct ieee80211_mgmt {
+	__le16 frame_control;
+	__le16 duration;
+	u8 da[ETH_ALEN];
+	u8 sa[ETH_ALEN];
+	u8 bssid[ETH_ALEN];
+	__le16 seq_ctrl;
+	union {
+		struct {
+			__le64 timestamp;
+			__le16 beacon_int;
+			__le16 capab_info;
+			u8 variable[0];
+		} __attribute__ ((packed)) beacon;
+	} u;
+} __attribute__ ((packed));
+
+#endif /* _ACX_SHIM_IEEE80211_H_ */
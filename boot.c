@@ -190,7 +190,115 @@ void acx_display_hardware_details(acx_device_t *adev)
 
 }
 
-firmware_image_t *acx_read_fw(struct device *dev, const char *file, u32 * size)
+/*
+ * Firmware cache
+ *
+ * One immutable copy per image name, shared by all adapters and
+ * counted by users. The last acx_release_fw() frees it, so a firmware
+ * file updated on disk is picked up by the next probe. Adapters hold
+ * theirs from probe to remove, for resume and acx_recover_hw().
+ */
+struct acx_fw_cache_entry {
+	struct list_head list;
+	const char *name;
+	firmware_image_t *image;
+	u32 size;
+	unsigned int users;
+};
+
+static LIST_HEAD(acx_fw_cache);
+static DEFINE_MUTEX(acx_fw_cache_mutex);
+
+static struct acx_fw_cache_entry *acx_fw_cache_find(const char *name,
+						const firmware_image_t *image)
+{
+	struct acx_fw_cache_entry *e;
+
+	list_for_each_entry(e, &acx_fw_cache, list)
+		if ((name && !strcmp(e->name, name)) || e->image == image)
+			return e;
+	return NULL;
+}
+
+/*
+ * Takes over a vmalloc()ed image and returns the cached one for name,
+ * which is the same unless somebody else was faster. Release it with
+ * acx_release_fw().
+ */
+const firmware_image_t *acx_fw_cache_add(const char *name,
+					firmware_image_t *image, u32 size)
+{
+	struct acx_fw_cache_entry *e;
+
+	if (!image)
+		return NULL;
+
+	mutex_lock(&acx_fw_cache_mutex);
+	e = acx_fw_cache_find(name, NULL);
+	if (e) {
+		vfree(image);
+		goto out;
+	}
+
+	e = kzalloc(sizeof(*e), GFP_KERNEL);
+	if (!e)
+		goto fail;
+	e->name = kstrdup(name, GFP_KERNEL);
+	if (!e->name) {
+		kfree(e);
+		goto fail;
+	}
+	e->image = image;
+	e->size = size;
+	list_add(&e->list, &acx_fw_cache);
+out:
+	e->users++;
+	mutex_unlock(&acx_fw_cache_mutex);
+	return e->image;
+
+fail:
+	mutex_unlock(&acx_fw_cache_mutex);
+	vfree(image);
+	return NULL;
+}
+
+void acx_release_fw(const firmware_image_t *image)
+{
+	struct acx_fw_cache_entry *e;
+
+	if (!image)
+		return;
+
+	mutex_lock(&acx_fw_cache_mutex);
+	e = acx_fw_cache_find(NULL, image);
+	if (WARN_ON(!e || !e->users) || --e->users)
+		e = NULL;
+	else
+		list_del(&e->list);
+	mutex_unlock(&acx_fw_cache_mutex);
+
+	if (e) {
+		vfree(e->image);
+		kfree(e->name);
+		kfree(e);
+	}
+}
+
+void acx_fw_cache_exit(void)
+{
+	struct acx_fw_cache_entry *e, *tmp;
+
+	list_for_each_entry_safe(e, tmp, &acx_fw_cache, list) {
+		WARN_ON(e->users);
+		list_del(&e->list);
+		vfree(e->image);
+		kfree(e->name);
+		kfree(e);
+	}
+}
+
+static firmware_image_t *acx_request_fw(struct device *dev, const char *file,
+					u32 *size)
 {
 	firmware_image_t *res;
 	const struct firmware *fw_entry;
@@ -226,6 +334,30 @@ firmware_image_t *acx_read_fw(struct device *dev, const char *file, u32 * size)
 	return res;
 }
 
+/* From the cache if possible, see acx_fw_cache_add() */
+const firmware_image_t *acx_read_fw(struct device *dev, const char *file,
+				u32 *size)
+{
+	struct acx_fw_cache_entry *e;
+	firmware_image_t *image;
+
+	mutex_lock(&acx_fw_cache_mutex);
+	e = acx_fw_cache_find(file, NULL);
+	if (e) {
+		e->users++;
+		*size = e->size;
+		log(L_INIT, "firmware image '%s' is cached\n", file);
+	}
+	mutex_unlock(&acx_fw_cache_mutex);
+	if (e)
+		return e->image;
+
+	/* not under the mutex, request_firmware() can take long */
+	image = acx_request_fw(dev, file, size);
+
+	return acx_fw_cache_add(file, image, *size);
+}
+
 /*
  * Common function to parse ALL configoption struct formats
  * (ACX100 and ACX111; FIXME: how to make it work with ACX100 USB!?!?).
@@ -240,7 +372,7 @@ void acx_parse_configoption(acx_device_t *adev,
 	int i;
 	int is_acx111 = IS_ACX111(adev);
 
-	if (acx_debug & L_DEBUG) {
+	if (acx_debug_enabled(L_DEBUG)) {
 		pr_info("configoption struct content:\n");
 		acx_dump_bytes(pcfg, sizeof(*pcfg));
 	}
@@ -516,6 +648,9 @@ int acx_reset_on_probe(acx_device_t *adev)
 		acxmem_init_acx_txbuf(adev);
 
 	/* adev->eeprom_version required in acx_parse_configoption() */
+	if (OK != acx_read_eeprom(adev))
+		pr_info("%s: EEPROM copy FAILED, reading it directly\n",
+			wiphy_name(adev->hw->wiphy));
 	acxmem_lock();
 	res=acx_read_eeprom_byte(adev, 0x05, &adev->eeprom_version);
 	acxmem_unlock();
@@ -3,7 +3,12 @@
 
 void acx_get_firmware_version(acx_device_t * adev);
 void acx_display_hardware_details(acx_device_t *adev);
-firmware_image_t *acx_read_fw(struct device *dev, const char *file, u32 * size);
+const firmware_image_t *acx_read_fw(struct device *dev, const char *file,
+				u32 *size);
+const firmware_image_t *acx_fw_cache_add(const char *name,
+					firmware_image_t *image, u32 size);
+void acx_release_fw(const firmware_image_t *image);
+void acx_fw_cache_exit(void);
 void acx_parse_configoption(acx_device_t *adev,
                             const acx111_ie_configoption_t *pcfg);
 
@@ -786,7 +786,7 @@ static int acx100_get_ed_threshold(acx_device_t *adev)
 	int res;
 	u8 *ed_threshold = adev->ie_cmd_buf;
 
-	memset(ed_threshold, 0, sizeof(adev->ie_cmd_buf_len));
+	memset(ed_threshold, 0, adev->ie_cmd_buf_len);
 	res = acx_interrogate(adev, ed_threshold,
 			  ACX100_IE_DOT11_ED_THRESHOLD);
 	adev->ed_threshold = ed_threshold[4];
@@ -834,9 +834,9 @@ static int acx100_update_ed_threshold(acx_device_t *adev)
 	int res;
 	u8 *ed_threshold = adev->ie_cmd_buf;
 
-	memset(ed_threshold, 0, sizeof(adev->ie_cmd_buf_len));
+	memset(ed_threshold, 0, adev->ie_cmd_buf_len);
 	ed_threshold[4] = adev->ed_threshold;
-	res = acx_configure(adev, &ed_threshold,
+	res = acx_configure(adev, ed_threshold,
 			ACX100_IE_DOT11_ED_THRESHOLD);
 
 
@@ -865,7 +865,7 @@ static int acx100_get_cca(acx_device_t *adev)
 	int res;
 	u8 *cca = adev->ie_cmd_buf;
 
-	memset(cca, 0, sizeof(adev->ie_cmd_buf_len));
+	memset(cca, 0, adev->ie_cmd_buf_len);
 	res = acx_interrogate(adev, cca,
 			ACX1xx_IE_DOT11_CURRENT_CCA_MODE);
 	adev->cca = cca[4];
@@ -911,7 +911,7 @@ static int acx100_update_cca(acx_device_t *adev)
 	int res;
 	u8 *cca = adev->ie_cmd_buf;
 
-	memset(cca, 0, sizeof(adev->ie_cmd_buf_len));
+	memset(cca, 0, adev->ie_cmd_buf_len);
 	cca[4] = adev->cca;
 	res = acx_configure(adev, cca,
 			ACX1xx_IE_DOT11_CURRENT_CCA_MODE);
@@ -1299,7 +1299,7 @@ int acx_set_tim_template(acx_device_t *adev, u8 *data, int len)
 
 
 
-	if (acx_debug & L_DEBUG) {
+	if (acx_debug_enabled(L_DEBUG)) {
 		logf1(L_ANY, "data, len=%d:\n", len);
 		acx_dump_bytes(data, len);
 	}
@@ -1390,7 +1390,7 @@ static int acx_set_beacon_template(acx_device_t *adev, u8 *data, int len)
 
 
 
-	if (acx_debug & L_DEBUG) {
+	if (acx_debug_enabled(L_DEBUG)) {
 		logf1(L_ANY, "data, len=%d, sizeof(struct"
 			"acx_template_beacon)=%d:\n",
 			len, (int)sizeof(struct acx_template_beacon));
@@ -1605,7 +1605,7 @@ static void acx_update_ratevector(acx_device_t *adev)
 		bcfg >>= 1;
 	}
 	adev->rate_supported_len = supp - adev->rate_supported;
-	if (acx_debug & L_ASSOC) {
+	if (acx_debug_enabled(L_ASSOC)) {
 		pr_info("new ratevector: ");
 		acx_dump_bytes(adev->rate_supported, adev->rate_supported_len);
 	}
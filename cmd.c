@@ -97,17 +97,22 @@ int acx_issue_cmd_timeout(acx_device_t *adev, enum acx_cmd cmd, void *param,
 {
 	const unsigned int cmdval = acx_cmd_descs[cmd].val;
 	const char *cmdstr = acx_cmd_descs[cmd].name;
+	int ret = NOT_OK;
+
+	acx_cmd_lock(adev);
 
 	if (IS_PCI(adev) || IS_MEM(adev))
-		return _acx_issue_cmd_timeo_debug(adev, cmdval, param, len,
+		ret = _acx_issue_cmd_timeo_debug(adev, cmdval, param, len,
 						timeout, cmdstr);
-	if (IS_USB(adev))
-		return acxusb_issue_cmd_timeo_debug(adev, cmdval, param, len,
+	else if (IS_USB(adev))
+		ret = acxusb_issue_cmd_timeo_debug(adev, cmdval, param, len,
 						timeout, cmdstr);
+	else
+		log(L_ANY, "Unsupported dev_type=%i\n", (adev)->dev_type);
 
-	log(L_ANY, "Unsupported dev_type=%i\n", (adev)->dev_type);
+	acx_cmd_unlock(adev);
 
-	return (NOT_OK);
+	return ret;
 }
 
 inline int acx_issue_cmd(acx_device_t *adev, enum acx_cmd cmd, void *param, unsigned len)
@@ -121,10 +126,10 @@ inline int acx_configure(acx_device_t *adev, void *pdr, enum acx_ie type)
 	return acx_configure_len(adev, pdr, type, acx_ie_descs[type].len);
 }
 
-int acx_configure_len(acx_device_t *adev, void *pdr, enum acx_ie type, u16 len)
+static int _acx_configure_len(acx_device_t *adev, void *pdr, enum acx_ie type,
+			u16 len)
 {
 	int res;
-	char msgbuf[255];
 
 	const u16 typeval = acx_ie_descs[type].val;
 	const char *typestr = acx_ie_descs[type].name;
@@ -136,17 +141,121 @@ int acx_configure_len(acx_device_t *adev, void *pdr, enum acx_ie type, u16 len)
 	((acx_ie_generic_t *) pdr)->len = cpu_to_le16(len);
 	res = acx_issue_cmd(adev, ACX1xx_CMD_CONFIGURE, pdr, len + 4);
 
-	sprintf(msgbuf, "%s: type=0x%04X, typestr=%s, len=%u",
-		wiphy_name(adev->hw->wiphy), typeval, typestr, len);
-
 	if (likely(res == OK))
-		log(L_DEBUG,  "%s: OK\n", msgbuf);
-	 else
-		log(L_ANY,  "%s: FAILED\n", msgbuf);
+		log(L_DEBUG, "%s: type=0x%04X, typestr=%s, len=%u: OK\n",
+			wiphy_name(adev->hw->wiphy), typeval, typestr, len);
+	else
+		log(L_ANY, "%s: type=0x%04X, typestr=%s, len=%u: FAILED\n",
+			wiphy_name(adev->hw->wiphy), typeval, typestr, len);
+
+	return res;
+}
+
+/*
+ * CONFIGURE shadow
+ *
+ * For the settings IEs below acx_configure_len() remembers the last
+ * value acked by the fw and skips the cmd if the same value comes
+ * again, so acx_update_settings() and the mac80211 config ops only
+ * spend mailbox time on what changed. Keys and the memory setup are
+ * never skipped.
+ *
+ * A reset brings back the fw defaults: acx_init_mac() invalidates the
+ * shadow first and replays it in one go once the fw is up again.
+ * Callers hold the acx-sem.
+ */
+static const enum acx_ie acx_shadowed_ies[ACX_IE_SHADOW_SLOTS] = {
+	ACX1xx_IE_DOT11_STATION_ID,
+	ACX1xx_IE_RATE_FALLBACK,
+	ACX1xx_IE_DOT11_TX_POWER_LEVEL,
+	ACX1xx_IE_DOT11_CURRENT_ANTENNA,
+	ACX100_IE_DOT11_ED_THRESHOLD,
+	ACX1xx_IE_DOT11_CURRENT_CCA_MODE,
+	ACX1xx_IE_DOT11_SHORT_RETRY_LIMIT,
+	ACX1xx_IE_DOT11_LONG_RETRY_LIMIT,
+	ACX1xx_IE_DOT11_MAX_XMIT_MSDU_LIFETIME,
+	ACX1xx_IE_DOT11_CURRENT_REG_DOMAIN,
+	ACX1xx_IE_FEATURE_CONFIG,
+	ACX1xx_IE_RXCONFIG,
+};
+
+static struct acx_ie_shadow *acx_ie_shadow_get(acx_device_t *adev,
+					enum acx_ie type, u16 len)
+{
+	int i;
+
+	if (len > ACX_IE_SHADOW_LEN)
+		return NULL;
+
+	for (i = 0; i < ACX_IE_SHADOW_SLOTS; i++)
+		if (acx_shadowed_ies[i] == type)
+			return &adev->ie_shadow[i];
+
+	return NULL;
+}
+
+int acx_configure_len(acx_device_t *adev, void *pdr, enum acx_ie type, u16 len)
+{
+	struct acx_ie_shadow *shadow = acx_ie_shadow_get(adev, type, len);
+	const u8 *data = ((acx_ie_generic_t *) pdr)->m.bytes;
+	int res;
+
+	if (shadow && shadow->valid && shadow->len == len
+		&& !memcmp(shadow->data, data, len)) {
+		log(L_DEBUG, "%s: typestr=%s unchanged, skipped\n",
+			wiphy_name(adev->hw->wiphy), acx_ie_descs[type].name);
+		return OK;
+	}
+
+	res = _acx_configure_len(adev, pdr, type, len);
+
+	if (shadow) {
+		if (likely(res == OK)) {
+			memcpy(shadow->data, data, len);
+			shadow->len = len;
+			shadow->valid = 1;
+		} else {
+			/* don't know what the fw holds now */
+			shadow->len = 0;
+			shadow->valid = 0;
+		}
+	}
 
 	return res;
 }
 
+/* The fw went back to its defaults */
+void acx_ie_shadow_invalidate(acx_device_t *adev)
+{
+	int i;
+
+	for (i = 0; i < ACX_IE_SHADOW_SLOTS; i++)
+		adev->ie_shadow[i].valid = 0;
+}
+
+/* Restore the settings lost by a reset */
+void acx_ie_shadow_replay(acx_device_t *adev)
+{
+	acx_ie_generic_t ie;
+	struct acx_ie_shadow *shadow;
+	int i;
+
+	BUILD_BUG_ON(ACX_IE_SHADOW_LEN > sizeof(ie.m.bytes));
+
+	for (i = 0; i < ACX_IE_SHADOW_SLOTS; i++) {
+		shadow = &adev->ie_shadow[i];
+		if (!shadow->len || shadow->valid)
+			continue;
+
+		memcpy(ie.m.bytes, shadow->data, shadow->len);
+		shadow->valid = (OK == _acx_configure_len(adev, &ie,
+						acx_shadowed_ies[i],
+						shadow->len));
+		if (!shadow->valid)
+			shadow->len = 0;
+	}
+}
+
 int acx_interrogate(acx_device_t *adev, void *pdr, enum acx_ie type)
 {
 	int res;
@@ -55,6 +55,8 @@ int acx_issue_cmd_timeout(acx_device_t *adev, enum acx_cmd cmd, void *buffer,
 
 int acx_configure(acx_device_t *adev, void *pdr, enum acx_ie type);
 int acx_configure_len(acx_device_t *adev, void *pdr, enum acx_ie type, u16 len);
+void acx_ie_shadow_invalidate(acx_device_t *adev);
+void acx_ie_shadow_replay(acx_device_t *adev);
 
 int acx_interrogate(acx_device_t *adev, void *pdr, enum acx_ie type);
 
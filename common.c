@@ -25,11 +25,13 @@
 #include "debug.h"
 #include "mem.h"
 #include "pci.h"
+#include "sim.h"
 #include "cmd.h"
 #include "ie.h"
 #include "utils.h"
 #include "cardsetting.h"
 #include "main.h"
+#include "boot.h"
 #include "debug.h"
 
 /* Firmware, EEPROM, Phy */
@@ -87,9 +89,10 @@ void great_inquisitor(acx_device_t * adev)
 
 static int __init acx_init_module(void)
 {
-	int r1, r2, r3;
+	int r1, r2, r3, r4;
 
 	acx_struct_size_check();
+	acx_debug_changed();
 
 	/* ACX_GIT_VERSION can be an empty string, if something went
 	   wrong before on Makefile/shell level. We trap this here
@@ -106,14 +109,16 @@ static int __init acx_init_module(void)
 
 	acx_debugfs_init();
 
-	r1 = r2 = r3 = -EINVAL;
+	r1 = r2 = r3 = r4 = -EINVAL;
 
 	r1 = acxpci_init_module();
 	r2 = acxusb_init_module();
 	r3 = acxmem_init_module();
+	r4 = acxsim_init_module();
 
-	if (r3 && r2 && r1) {		/* all three failed! */
-		pr_info("r1_pci=%i, r2_usb=%i, r3_mem=%i\n", r1, r2, r3);
+	if (r4 && r3 && r2 && r1) {	/* all failed! */
+		pr_info("r1_pci=%i, r2_usb=%i, r3_mem=%i, r4_sim=%i\n",
+			r1, r2, r3, r4);
 		goto errout;
 	}
 
@@ -131,8 +136,10 @@ static void __exit acx_cleanup_module(void)
 	acxpci_cleanup_module();
 	acxusb_cleanup_module();
 	acxmem_cleanup_module();
+	acxsim_cleanup_module();
 
 	acx_debugfs_exit();
+	acx_fw_cache_exit();
 }
 
 /*
@@ -151,13 +158,96 @@ unsigned int acx_watchdog_enable = 0;
 module_param_named(watchdog, acx_watchdog_enable, uint, 0644);
 MODULE_PARM_DESC(debug, "Enable watchdog");
 
+unsigned int acx_rx_zerocopy = 1;
+module_param_named(rxzerocopy, acx_rx_zerocopy, uint, 0444);
+MODULE_PARM_DESC(rxzerocopy, "PCI: pass rx dma buffers up without copying");
+
+unsigned int acx_tx_zerocopy = 1;
+module_param_named(txzerocopy, acx_tx_zerocopy, uint, 0444);
+MODULE_PARM_DESC(txzerocopy, "PCI: dma-map tx skbs instead of copying them");
+
+unsigned int acx_rx_budget = RX_CNT_DEFAULT;
+module_param_named(rxbudget, acx_rx_budget, uint, 0644);
+MODULE_PARM_DESC(rxbudget, "PCI/MEM: max rx frames per irq_work pass");
+
+unsigned int acx_rx_ring = RX_CNT_DEFAULT;
+module_param_named(rxring, acx_rx_ring, uint, 0444);
+MODULE_PARM_DESC(rxring, "PCI/MEM: rx descriptor ring depth (8-64)");
+
+unsigned int acx_tx_ring = TX_CNT_DEFAULT;
+module_param_named(txring, acx_tx_ring, uint, 0444);
+MODULE_PARM_DESC(txring, "PCI/MEM: tx descriptor ring depth (8-64)");
+
+unsigned int acx_fw_burst = 1;
+module_param_named(fwburst, acx_fw_burst, uint, 0644);
+MODULE_PARM_DESC(fwburst, "PCI: upload firmware in auto-increment bursts "
+	"(0: word by word)");
+
+unsigned int acx_fw_validate = 1;
+module_param_named(fwvalidate, acx_fw_validate, uint, 0644);
+MODULE_PARM_DESC(fwvalidate, "Read back all of the uploaded firmware "
+	"(0: spot checks only, the image checksum is always verified)");
+
+unsigned int acx_irq_coalesce = 0;
+module_param_named(irqcoalesce, acx_irq_coalesce, uint, 0644);
+MODULE_PARM_DESC(irqcoalesce, "PCI/MEM: pkts/s above which tx/rx irqs are "
+	"masked and cleaned from a timer (0: off)");
+
+#if defined(CONFIG_ACX_MAC80211_SIM)
+unsigned int acx_sim_devs = 0;
+module_param_named(simdevs, acx_sim_devs, uint, 0444);
+MODULE_PARM_DESC(simdevs, "SIM: number of simulated acx111 devices (0-8)");
+
+unsigned int acx_sim_rx_pps = 0;
+module_param_named(simrxpps, acx_sim_rx_pps, uint, 0644);
+MODULE_PARM_DESC(simrxpps, "SIM: rx frames/s injected while rx is enabled");
+
+unsigned int acx_sim_rx_len = 1500;
+module_param_named(simrxlen, acx_sim_rx_len, uint, 0644);
+MODULE_PARM_DESC(simrxlen, "SIM: length of injected rx frames (32-2328)");
+#endif
+
 #if ACX_DEBUG
 
 /* will add __read_mostly later */
 unsigned int acx_debug = ACX_DEFAULT_MSG;
 
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 3, 0)
+DEFINE_STATIC_KEY_FALSE(acx_debug_key);
+
+/* Writers of acx_debug race, so the last one to get here wins */
+static DEFINE_MUTEX(acx_debug_mutex);
+
+void acx_debug_changed(void)
+{
+	mutex_lock(&acx_debug_mutex);
+	if (READ_ONCE(acx_debug) & ~ACX_DEBUG_SLOWPATH)
+		static_branch_enable(&acx_debug_key);
+	else
+		static_branch_disable(&acx_debug_key);
+	mutex_unlock(&acx_debug_mutex);
+}
+
+static int acx_debug_set(const char *val, const struct kernel_param *kp)
+{
+	int res = param_set_uint(val, kp);
+
+	if (!res)
+		acx_debug_changed();
+	return res;
+}
+
+static struct kernel_param_ops acx_debug_ops = {
+	.get = param_get_uint,
+	.set = acx_debug_set,
+};
+
+/* parameter is 'debug', corresponding var is acx_debug */
+module_param_cb(debug, &acx_debug_ops, &acx_debug, 0644);
+#else
 /* parameter is 'debug', corresponding var is acx_debug */
 module_param_named(debug, acx_debug, uint, 0644);
+#endif
 MODULE_PARM_DESC(debug, "Debug level mask (see L_xxx constants)");
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 36)
@@ -220,9 +310,11 @@ static int acx_debug_flag_set(const char *val, const struct kernel_param *kp)
 		}
 		if (i == ARRAY_SIZE(flag_names)) {
 			pr_err("no match on val: %s\n", p);
+			acx_debug_changed();
 			return -EINVAL;
 		}
 	}
+	acx_debug_changed();
 	return 0;
 }
 
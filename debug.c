@@ -37,10 +37,15 @@
 #include "main.h"
 #include "boot.h"
 #include "debug.h"
+#include "bench.h"
 
 enum file_index {
 	INFO, DIAG, EEPROM, PHY, DEBUG,
 	SENSITIVITY, TX_LEVEL, ANTENNA, REG_DOMAIN,
+	RING_SIZE,
+	COALESCE,
+	BENCH,
+	TX_LATENCY,
 };
 static const char *const dbgfs_files[] = {
 	[INFO]		= "info",
@@ -52,9 +57,13 @@ static const char *const dbgfs_files[] = {
 	[TX_LEVEL]	= "tx_level",
 	[ANTENNA]	= "antenna",
 	[REG_DOMAIN]	= "reg_domain",
+	[RING_SIZE]	= "ring_size",
+	[COALESCE]	= "coalesce",
+	[BENCH]		= "bench",
+	[TX_LATENCY]	= "tx_latency",
 };
-BUILD_BUG_DECL(dbgfs_files__VS__enum_REG_DOMAIN,
-	ARRAY_SIZE(dbgfs_files) != REG_DOMAIN + 1);
+BUILD_BUG_DECL(dbgfs_files__VS__enum_TX_LATENCY,
+	ARRAY_SIZE(dbgfs_files) != TX_LATENCY + 1);
 
 static struct dentry *acx_dbgfs_dir;
 
@@ -603,6 +612,7 @@ static ssize_t acx_dbgfs_write_debug(acx_device_t *adev, struct file *file,
 	if (count == size) {
 		ret = count;
 		acx_debug = val;
+		acx_debug_changed();
 	}
 
 	log(L_ANY, "acx_debug=0x%04x\n", acx_debug);
@@ -798,6 +808,149 @@ out:
 	return ret;
 }
 
+static int acx_dbgfs_show_ring_size(struct seq_file *file, void *v)
+{
+	acx_device_t *adev = (acx_device_t *) file->private;
+
+	acx_sem_lock(adev);
+
+	seq_printf(file, "rx_cnt: %u (next reset: %u)\n"
+		"tx_cnt: %u (next reset: %u)\n",
+		adev->rx_cnt, adev->rx_cnt_cfg,
+		adev->tx_cnt, adev->tx_cnt_cfg);
+
+	acx_sem_unlock(adev);
+
+	return 0;
+}
+
+/* Value is 0xTTRR (tx, rx ring depth), as for antenna. Applied when
+ * the rings are rebuilt, e.g. by ACX_DIAG_OP_RECOVER_HW or resume. */
+static ssize_t acx_dbgfs_write_ring_size(acx_device_t *adev, struct file *file,
+                                        const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	ssize_t ret = -EINVAL;
+	char *after, buf[32];
+	unsigned long val;
+	unsigned int rx_cnt, tx_cnt;
+	size_t size, len;
+
+
+	len = min(count, sizeof(buf) - 1);
+	if (unlikely(copy_from_user(buf, ubuf, len)))
+		return -EFAULT;
+	buf[len] = '\0';
+
+	val = simple_strtoul(buf, &after, 0);
+	size = after - buf + 1;
+
+	if (count != size)
+		return ret;
+
+	acx_sem_lock(adev);
+
+	rx_cnt = val & 0xFF;
+	tx_cnt = (val >> 8) & 0xFF;
+	if (rx_cnt < RING_CNT_MIN || rx_cnt > RING_CNT_MAX
+		|| tx_cnt < RING_CNT_MIN || tx_cnt > RING_CNT_MAX)
+		goto out;
+
+	ret = count;
+
+	adev->rx_cnt_cfg = rx_cnt;
+	adev->tx_cnt_cfg = tx_cnt;
+	logf1(L_ANY, "ring depths for next reset: rx %u, tx %u\n",
+		rx_cnt, tx_cnt);
+
+out:
+	acx_sem_unlock(adev);
+
+	return ret;
+}
+
+static int acx_dbgfs_show_coalesce(struct seq_file *file, void *v)
+{
+	acx_device_t *adev = (acx_device_t *) file->private;
+
+	acx_sem_lock(adev);
+
+	seq_printf(file, "threshold: %u pkts/s\n"
+		"active: %d\n"
+		"last_pps: %u\n"
+		"irqs: %lu\n"
+		"timer_polls: %lu\n"
+		"bursts: %lu\n",
+		acx_irq_coalesce, adev->coalesce.active,
+		adev->coalesce.last_pps, adev->coalesce.irqs,
+		adev->coalesce.timer_polls, adev->coalesce.bursts);
+
+	acx_sem_unlock(adev);
+
+	return 0;
+}
+
+static int acx_dbgfs_show_bench(struct seq_file *file, void *v)
+{
+	return acx_bench_show(file, (acx_device_t *) file->private);
+}
+
+/* Per hw queue log2 histograms, see acx_tx_lat_add(). Empty buckets
+ * are left out. */
+static int acx_dbgfs_show_tx_latency(struct seq_file *file, void *v)
+{
+	acx_device_t *adev = (acx_device_t *) file->private;
+	unsigned long (*hist)[ACX_TX_LAT_BUCKETS];
+	int q, b;
+
+	acx_sem_lock(adev);
+
+	for (q = 0; q < adev->num_hw_tx_queues; q++) {
+		hist = adev->hw_tx_queue[q].lat_hist;
+
+		seq_printf(file, "queue %d:\n%18s %10s %10s %10s\n", q,
+			"usecs", "queued", "hw", "total");
+		for (b = 0; b < ACX_TX_LAT_BUCKETS; b++) {
+			if (!hist[ACX_TX_LAT_QUEUE][b] && !hist[ACX_TX_LAT_HW][b]
+				&& !hist[ACX_TX_LAT_TOTAL][b])
+				continue;
+
+			if (b == 0)
+				seq_printf(file, "%18s", "< 1");
+			else if (b == ACX_TX_LAT_BUCKETS - 1)
+				seq_printf(file, "%7s >= %7lu", "", 1UL << (b - 1));
+			else
+				seq_printf(file, "%8lu - %7lu",
+					1UL << (b - 1), 1UL << b);
+			seq_printf(file, " %10lu %10lu %10lu\n",
+				hist[ACX_TX_LAT_QUEUE][b],
+				hist[ACX_TX_LAT_HW][b],
+				hist[ACX_TX_LAT_TOTAL][b]);
+		}
+	}
+
+	acx_sem_unlock(adev);
+
+	return 0;
+}
+
+/* Any write clears the histograms. Frames in flight may still be
+ * counted into the fresh ones. */
+static ssize_t acx_dbgfs_write_tx_latency(acx_device_t *adev,
+					struct file *file,
+					const char __user *ubuf, size_t count,
+					loff_t *ppos)
+{
+	int q;
+
+	acx_sem_lock(adev);
+	for (q = 0; q < adev->num_hw_tx_queues; q++)
+		memset(adev->hw_tx_queue[q].lat_hist, 0,
+			sizeof(adev->hw_tx_queue[q].lat_hist));
+	acx_sem_unlock(adev);
+
+	return count;
+}
+
 static acx_dbgfs_show_t *const acx_dbgfs_show_funcs[] = {
 	acx_dbgfs_show_acx,
 	acx_dbgfs_show_diag,
@@ -808,6 +961,10 @@ static acx_dbgfs_show_t *const acx_dbgfs_show_funcs[] = {
 	acx_dbgfs_show_tx_level,
 	acx_dbgfs_show_antenna,
 	acx_dbgfs_show_reg_domain,
+	acx_dbgfs_show_ring_size,
+	acx_dbgfs_show_coalesce,
+	acx_dbgfs_show_bench,
+	acx_dbgfs_show_tx_latency,
 };
 
 static acx_dbgfs_write_t *const acx_dbgfs_write_funcs[] = {
@@ -820,6 +977,10 @@ static acx_dbgfs_write_t *const acx_dbgfs_write_funcs[] = {
 	acx_dbgfs_write_tx_level,
 	acx_dbgfs_write_antenna,
 	acx_dbgfs_write_reg_domain,
+	acx_dbgfs_write_ring_size,
+	NULL,
+	acx_bench_write,
+	acx_dbgfs_write_tx_latency,
 };
 BUILD_BUG_DECL(acx_proc_show_funcs__VS__acx_proc_write_funcs,
 	ARRAY_SIZE(acx_dbgfs_show_funcs) != ARRAY_SIZE(acx_dbgfs_write_funcs));
@@ -840,6 +1001,10 @@ static int acx_dbgfs_open(struct inode *inode, struct file *file)
 	case TX_LEVEL:
 	case ANTENNA:
 	case REG_DOMAIN:
+	case RING_SIZE:
+	case COALESCE:
+	case BENCH:
+	case TX_LATENCY:
 		pr_devel("opening filename=%s fmode=%o fidx=%d adev=%p\n",
 			dbgfs_files[fidx], file->f_mode, (int)fidx, adev);
 		break;
@@ -869,6 +1034,10 @@ static ssize_t acx_dbgfs_write(struct file *file, const char __user *buf,
 	case TX_LEVEL:
 	case ANTENNA:
 	case REG_DOMAIN:
+	case RING_SIZE:
+	case COALESCE:
+	case BENCH:
+	case TX_LATENCY:
 		pr_devel("opening filename=%s fmode=%o fidx=%d adev=%p\n",
 			dbgfs_files[fidx], file->f_mode, (int)fidx, adev);
 		break;
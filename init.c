@@ -182,6 +182,28 @@ success:
 	return result;
 }
 
+/*
+ * acx_update_ring_cnt
+ *
+ * Pick up ring depths changed through debugfs. This is only safe when
+ * the rings get rebuilt anyway, so the old host descriptors and
+ * buffers are dropped here and reallocated at the new size.
+ */
+static void acx_update_ring_cnt(acx_device_t *adev)
+{
+	if (adev->rx_cnt == adev->rx_cnt_cfg
+		&& adev->tx_cnt == adev->tx_cnt_cfg)
+		return;
+
+	if (IS_PCI(adev) || IS_MEM(adev))
+		acx_free_desc_queues(adev);
+
+	log(L_INIT, "ring depths rx %u->%u, tx %u->%u\n",
+		adev->rx_cnt, adev->rx_cnt_cfg, adev->tx_cnt, adev->tx_cnt_cfg);
+	adev->rx_cnt = adev->rx_cnt_cfg;
+	adev->tx_cnt = adev->tx_cnt_cfg;
+}
+
 /*
  * acx111_s_create_dma_regions
  *
@@ -197,6 +219,7 @@ static int acx111_create_dma_regions(acx_device_t *adev)
 	u32 rx_queue_start;
 	u32 tx_queue_start[ACX111_NUM_HW_TX_QUEUES];
 
+	acx_update_ring_cnt(adev);
 	adev->num_hw_tx_queues = ACX111_NUM_HW_TX_QUEUES;
 
 	/* Calculate memory positions and queue sizes */
@@ -229,7 +252,7 @@ static int acx111_create_dma_regions(acx_device_t *adev)
 	 * (specified in units of 5%) */
 	memconf.fragmentation = ACX111_PERCENT(75);
 	/* Rx descriptor queue config */
-	memconf.rx_queue1_count_descs = RX_CNT;
+	memconf.rx_queue1_count_descs = adev->rx_cnt;
 	memconf.rx_queue1_type = 7;	/* must be set to 7 */
 
 	/* done by memset: memconf.rx_queue1_prio = 0; low prio */
@@ -248,7 +271,7 @@ static int acx111_create_dma_regions(acx_device_t *adev)
 
 	/* Tx descriptor queue config */
 	for (i = 0; i < ACX111_NUM_HW_TX_QUEUES; i++) {
-		memconf.tx_queue[i].count_descs = TX_CNT;
+		memconf.tx_queue[i].count_descs = adev->tx_cnt;
 
 		// TODO check if prio if up- or downwards
 		/* done by memset: memconf.tx_queue1_attributes = 0; lowest priority */
@@ -498,6 +521,14 @@ static int acx100_init_memory_pools(acx_device_t *adev,
 	 */
 	adev->acx_txbuf_start = MemoryConfigOption.tx_mem;
 	adev->acx_txbuf_numblocks = MemoryConfigOption.TxBlockNum;
+
+	if (IS_MEM(adev)) {
+		kfree(adev->acx_txbuf_links);
+		adev->acx_txbuf_links = kcalloc(adev->acx_txbuf_numblocks,
+					sizeof(u32), GFP_KERNEL);
+		if (!adev->acx_txbuf_links)
+			goto bad;
+	}
 #endif
 
 
@@ -521,6 +552,7 @@ static int acx100_create_dma_regions(acx_device_t * adev)
 	int res = NOT_OK;
 	u32 tx_queue_start, rx_queue_start;
 
+	acx_update_ring_cnt(adev);
 	adev->num_hw_tx_queues = ACX100_NUM_HW_TX_QUEUES;
 
 	/* read out the acx100 physical start address for the queues */
@@ -528,7 +560,7 @@ static int acx100_create_dma_regions(acx_device_t * adev)
 		goto fail;
 
 	tx_queue_start = le32_to_cpu(memmap.QueueStart);
-	rx_queue_start = tx_queue_start + TX_CNT * sizeof(txacxdesc_t);
+	rx_queue_start = tx_queue_start + adev->tx_cnt * sizeof(txacxdesc_t);
 
 	log(L_DEBUG, "Initializing Queue Indicator\n");
 
@@ -541,8 +573,8 @@ static int acx100_create_dma_regions(acx_device_t * adev)
 	}
 
 	/* calculate size of queues */
-	queueconf.AreaSize = cpu_to_le32(TX_CNT * sizeof(txacxdesc_t) +
-					 RX_CNT * sizeof(rxacxdesc_t) + 8);
+	queueconf.AreaSize = cpu_to_le32(adev->tx_cnt * sizeof(txacxdesc_t) +
+					 adev->rx_cnt * sizeof(rxacxdesc_t) + 8);
 	queueconf.NumTxQueues = 1;	/* number of tx queues */
 	/* sets the beginning of the tx descriptor queue */
 	queueconf.TxQueueStart = memmap.QueueStart;
@@ -551,7 +583,7 @@ static int acx100_create_dma_regions(acx_device_t * adev)
 	queueconf.QueueOptions = 1;	/* auto reset descriptor */
 	/* sets the end of the rx descriptor queue */
 	queueconf.QueueEnd =
-	    cpu_to_le32(rx_queue_start + RX_CNT * sizeof(rxacxdesc_t)
+	    cpu_to_le32(rx_queue_start + adev->rx_cnt * sizeof(rxacxdesc_t)
 	    );
 	/* sets the beginning of the next queue */
 	queueconf.HostQueueEnd =
@@ -612,6 +644,9 @@ int acx_init_mac(acx_device_t * adev)
 {
 	int result = NOT_OK;
 
+	/* Fresh fw, see acx_configure_len() */
+	acx_ie_shadow_invalidate(adev);
+
 	if (IS_PCI(adev) || IS_MEM(adev) ) {
 		adev->memblocksize = 256;	/* 256 is default */
 		/* try to load radio for both ACX100 and ACX111, since both
@@ -649,6 +684,8 @@ int acx_init_mac(acx_device_t * adev)
 		}
 	}
 
+	acx_ie_shadow_replay(adev);
+
 	result = OK;
 fail:
 	if (result)
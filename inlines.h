@@ -1,6 +1,8 @@
 #ifndef _INLINES_H_
 #define _INLINES_H_
 
+#include "sim.h"
+
 /* ##################################################
  * BOM Data Access
  * Locking in mem
@@ -76,6 +78,89 @@
 	else							\
 		__release(&adev->spinlock)
 
+/*
+ * The tx rings are filled from tx_work and, on pci, directly from
+ * acx_op_tx() (see acx_tx_fast()), neither of which take the
+ * acx-sem. The submission paths are serialized by the tx_lock. Tx
+ * cleanup doesn't take it, see the tx ring accounting below.
+ */
+#define acx_tx_lock(adev)	spin_lock_bh(&(adev)->tx_lock)
+#define acx_tx_unlock(adev)	spin_unlock_bh(&(adev)->tx_lock)
+
+/* Rx ring processing in irq_work. Taken inside acxmem_lock() on mem,
+ * so not the _bh variant */
+#define acx_rx_lock(adev)	spin_lock(&(adev)->rx_lock)
+#define acx_rx_unlock(adev)	spin_unlock(&(adev)->rx_lock)
+
+/*
+ * Tx ring accounting
+ *
+ * The hw tx rings are single-producer/single-consumer: the tx path
+ * (under tx_lock/acx-sem) owns head and queued, the cleanup in
+ * irq_work (usb: the tx urb completion) owns tail and cleaned. Both
+ * counters are free running, so neither side writes what the other
+ * one reads.
+ *
+ * The producer publishes a desc with acx_tx_queued() after it is
+ * fully set up, the consumer gives descs back with acx_tx_cleaned()
+ * after it is done with them. The release/acquire pairs order the
+ * desc accesses against the counter updates.
+ */
+static inline unsigned int acx_tx_free(acx_device_t *adev, int q)
+{
+	struct hw_tx_queue *txq = &adev->hw_tx_queue[q];
+
+	return adev->tx_cnt
+		- (READ_ONCE(txq->queued) - smp_load_acquire(&txq->cleaned));
+}
+
+/* Consumer: number of published descs not yet cleaned */
+static inline unsigned int acx_tx_pending(acx_device_t *adev, int q)
+{
+	struct hw_tx_queue *txq = &adev->hw_tx_queue[q];
+
+	return smp_load_acquire(&txq->queued) - txq->cleaned;
+}
+
+static inline void acx_tx_queued(acx_device_t *adev, int q)
+{
+	struct hw_tx_queue *txq = &adev->hw_tx_queue[q];
+
+	smp_store_release(&txq->queued, txq->queued + 1);
+}
+
+static inline void acx_tx_cleaned(acx_device_t *adev, int q, unsigned int n)
+{
+	struct hw_tx_queue *txq = &adev->hw_tx_queue[q];
+
+	smp_store_release(&txq->cleaned, txq->cleaned + n);
+}
+
+/*
+ * Tx latency histograms, log2 of the usecs between from and to. Each
+ * stage has a single writer, so no locking.
+ */
+static inline void acx_tx_lat_add(acx_device_t *adev, int q, int stage,
+				ktime_t from, ktime_t to)
+{
+	s64 us = ktime_us_delta(to, from);
+	int bucket = 0;
+
+	if (us > 0)
+		bucket = min_t(int, fls64(us), ACX_TX_LAT_BUCKETS - 1);
+
+	adev->hw_tx_queue[q].lat_hist[stage][bucket]++;
+}
+
+/*
+ * The acx_op_tx() stamp is no wall clock time, don't let it leak to
+ * monitor interfaces with the tx status
+ */
+static inline void acx_tx_lat_clear(struct sk_buff *skb)
+{
+	skb->tstamp = ktime_set(0, 0);
+}
+
 /* Endianess: read[lw], write[lw] do little-endian conversion internally */
 #define acx_readl(v)		readl((v))
 #define acx_readw(v)		readw((v))
@@ -152,6 +237,8 @@ INLINE_IO u32 read_reg32(acx_device_t *adev, unsigned int offset)
 	u32 addr;
 
 	if (IS_PCI(adev)) {
+		if (IS_SIM(adev))
+			return acxsim_read_reg(adev, offset);
 		#if ACX_IO_WIDTH == 32
 		return acx_readl(adev->iobase + adev->io[offset]);
 		#else
@@ -176,8 +263,11 @@ INLINE_IO u16 read_reg16(acx_device_t *adev, unsigned int offset)
 	u16 lo;
 	u32 addr;
 
-	if (IS_PCI(adev))
+	if (IS_PCI(adev)) {
+		if (IS_SIM(adev))
+			return acxsim_read_reg(adev, offset);
 		return acx_readw(adev->iobase + adev->io[offset]);
+	}
 
 	/* else IS_MEM */
 
@@ -196,8 +286,11 @@ INLINE_IO u8 read_reg8(acx_device_t *adev, unsigned int offset)
 	u8 lo;
 	u32 addr;
 
-	if (IS_PCI(adev))
+	if (IS_PCI(adev)) {
+		if (IS_SIM(adev))
+			return acxsim_read_reg(adev, offset);
 		return readb(adev->iobase + adev->io[offset]);
+	}
 
 	/* else IS_MEM */
 
@@ -216,6 +309,10 @@ INLINE_IO void write_reg32(acx_device_t *adev, unsigned int offset, u32 val)
 	u32 addr;
 
 	if (IS_PCI(adev)) {
+		if (IS_SIM(adev)) {
+			acxsim_write_reg(adev, offset, val);
+			return;
+		}
 		#if ACX_IO_WIDTH == 32
 		acx_writel(val, adev->iobase + adev->io[offset]);
 		#else
@@ -240,6 +337,10 @@ INLINE_IO void write_reg16(acx_device_t *adev, unsigned int offset, u16 val)
 	u32 addr;
 
 	if (IS_PCI(adev)) {
+		if (IS_SIM(adev)) {
+			acxsim_write_reg(adev, offset, val);
+			return;
+		}
 		acx_writew(val, adev->iobase + adev->io[offset]);
 		return;
 	}
@@ -258,6 +359,10 @@ INLINE_IO void write_reg8(acx_device_t *adev, unsigned int offset, u8 val)
 	u32 addr;
 
 	if (IS_PCI(adev)) {
+		if (IS_SIM(adev)) {
+			acxsim_write_reg(adev, offset, val);
+			return;
+		}
 		writeb(val, adev->iobase + adev->io[offset]);
 		return;
 	}
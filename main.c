@@ -36,6 +36,7 @@
 
 #include "acx_func.h"
 #include "boot.h"
+#include "trace.h"
 
 /*
  * General Mac-related Definitions
@@ -457,12 +458,63 @@ static void acx_watchdog_work(struct work_struct *work)
 	return;
 }
 
+/*
+ * Async probe
+ *
+ * The bus probe sets up the bus side and the irq, then hands the slow
+ * part - firmware load and upload, mac init and
+ * ieee80211_register_hw() - to finish() and returns, so that several
+ * adapters come up in parallel. finish() cleans up after itself on
+ * failure, the device stays bound but unregistered.
+ *
+ * Remove and the pm hooks must acx_probe_wait() before touching the
+ * device. Busses which still probe synchronously don't need to.
+ */
+static void acx_probe_work(struct work_struct *work)
+{
+	acx_device_t *adev = container_of(work, struct acx_device, probe_work);
+
+	adev->probe_result = adev->probe_finish(adev);
+	if (adev->probe_result)
+		pr_err("%s: device init FAILED: %d\n",
+			wiphy_name(adev->hw->wiphy), adev->probe_result);
+
+	complete_all(&adev->probe_done);
+}
+
+void acx_probe_async(acx_device_t *adev, int (*finish)(acx_device_t *adev))
+{
+	adev->probe_finish = finish;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 36)
+	schedule_work(&adev->probe_work);
+#else
+	queue_work(system_unbound_wq, &adev->probe_work);
+#endif
+}
+
+/* Returns the result of finish(), 0 if the hw got registered */
+int acx_probe_wait(acx_device_t *adev)
+{
+	if (!adev->probe_finish)
+		return OK;
+
+	wait_for_completion(&adev->probe_done);
+
+	return adev->probe_result;
+}
+
 /* Locking, queueing, etc. mechanics */
 int acx_init_mechanics(acx_device_t *adev)
 {
 	/* Locking */
 	spin_lock_init(&adev->spinlock);
+	spin_lock_init(&adev->tx_lock);
+	spin_lock_init(&adev->rx_lock);
 	mutex_init(&adev->mutex);
+	mutex_init(&adev->cmd_mutex);
+
+	/* Firmware cmds */
+	init_completion(&adev->cmd_complete);
 
 	/* Irq work */
 	if (IS_USB(adev))
@@ -470,12 +522,31 @@ int acx_init_mechanics(acx_device_t *adev)
 	else
 		INIT_WORK(&adev->irq_work, acx_irq_work);
 
+	/* Coalesced ring clean, only armed on pci and mem */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 15, 0)
+	hrtimer_setup(&adev->coalesce_timer, acx_coalesce_timer,
+		CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#else
+	hrtimer_init(&adev->coalesce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	adev->coalesce_timer.function = acx_coalesce_timer;
+#endif
+
 	/* Skb tx-queue from mac80211 */
 	INIT_WORK(&adev->tx_work, acx_tx_work);
 	skb_queue_head_init(&adev->tx_queue);
 
 	INIT_DELAYED_WORK(&adev->watchdog_work, acx_watchdog_work);
 
+	/* Async probe */
+	INIT_WORK(&adev->probe_work, acx_probe_work);
+	init_completion(&adev->probe_done);
+
+	/* Ring depths */
+	adev->rx_cnt = adev->rx_cnt_cfg =
+		clamp_t(unsigned int, acx_rx_ring, RING_CNT_MIN, RING_CNT_MAX);
+	adev->tx_cnt = adev->tx_cnt_cfg =
+		clamp_t(unsigned int, acx_tx_ring, RING_CNT_MIN, RING_CNT_MAX);
+
 	/* Allocate IE cmd buffer */
 	adev->ie_cmd_buf_len=acx_ie_get_max_len()+4;
 	log(L_INIT, "ie_cmd_buf_len=%d\n", adev->ie_cmd_buf_len);
@@ -490,6 +561,7 @@ int acx_init_mechanics(acx_device_t *adev)
 int acx_free_mechanics(acx_device_t *adev)
 {
 	kfree(adev->ie_cmd_buf);
+	kfree(adev->acx_txbuf_links);
 
 	return 0;
 }
@@ -855,7 +927,7 @@ int acx_op_set_key(struct ieee80211_hw *hw, enum set_key_cmd cmd,
 			"flags=%02x, keyidx=%d, keylen=%d\n", key->cipher, key->icv_len,
 	        key->iv_len, key->hw_key_idx, key->flags, key->keyidx,
 	        key->keylen);
-	if (acx_debug & L_DEBUG)
+	if (acx_debug_enabled(L_DEBUG))
 		hexdump("key->: key", key->key, key->keylen);
 #endif
 
@@ -1019,7 +1091,7 @@ int acx_e_op_get_tx_stats(struct ieee80211_hw *hw,
 	acx_sem_lock(adev);
 
 	stats->len = 0;
-	stats->limit = TX_CNT;
+	stats->limit = adev->tx_cnt;
 	stats->count = 0;
 
 	acx_sem_unlock(adev);
@@ -1041,13 +1113,24 @@ void acx_op_tx(struct ieee80211_hw *hw, struct ieee80211_tx_control *control,
 {
 	acx_device_t *adev = hw2adev(hw);
 
+	/* tx latency histograms, see _acx_tx_data() */
+	if (!IS_USB(adev))
+		skb->tstamp = ktime_get();
+
+	trace_acx_tx_enqueue(adev, skb);
+
+	/* pci: submit directly if the hw ring has room */
+	if (!acx_tx_fast(adev, skb))
+		goto out;
+
 	skb_queue_tail(&adev->tx_queue, skb);
 
 	ieee80211_queue_work(adev->hw, &adev->tx_work);
 
-	if (skb_queue_len(&adev->tx_queue) >= ACX_TX_QUEUE_MAX_LENGTH)
+	if (skb_queue_len(&adev->tx_queue) >= ACX_TX_QUEUE_MAX_LENGTH(adev))
 		acx_stop_queue(adev->hw, NULL);
 
+out:
 	#if CONFIG_ACX_MAC80211_VERSION < KERNEL_VERSION(2, 6, 39)
 	return 0;
 	#else
@@ -1141,6 +1224,7 @@ int acx_op_hw_scan(struct ieee80211_hw *hw, struct ieee80211_vif *vif,
 int acx_recover_hw(acx_device_t *adev)
 {
 	log(L_ANY, "");
+	trace_acx_recover(adev);
 
 	acx_remove_interface(adev, adev->vif);
 	acx_stop(adev);
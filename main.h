@@ -13,6 +13,9 @@ struct ieee80211_hw* acx_alloc_hw(const struct ieee80211_ops *hw_ops);
 int acx_start_watchdog(acx_device_t *adev);
 int acx_stop_watchdog(acx_device_t *adev);
 
+void acx_probe_async(acx_device_t *adev, int (*finish)(acx_device_t *adev));
+int acx_probe_wait(acx_device_t *adev);
+
 int acx_init_mechanics(acx_device_t *adev);
 int acx_free_mechanics(acx_device_t *adev);
 int acx_init_ieee80211(acx_device_t *adev, struct ieee80211_hw *hw);
@@ -182,46 +182,36 @@ void acxmem_dump_mem(acx_device_t *adev, u32 start, int length)
 /*
  * Copy from slave memory
  *
- * TODO - rewrite using address autoincrement, handle partial words
+ * Burst: the address is written once, then each SLV_MEM_DATA read
+ * advances it in auto-increment mode. A partial last word is read
+ * whole and copied out bytewise.
  */
 /* = static */
 void acxmem_copy_from_slavemem(acx_device_t *adev, u8 *destination,
 			u32 source, int count)
 {
-	u32 tmp = 0;
-	u8 *ptmp = (u8 *) &tmp;
+	u32 tmp;
 
 	ACXMEM_WARN_NOT_SPIN_LOCKED;
 
-	/*
-	 * Right now I'm making the assumption that the destination is
-	 * aligned, but I'd better check.
-	 */
-	if ((uintptr_t) destination & 3) {
-		pr_acx("copy_from_slavemem: warning!  destination not word-aligned!\n");
-	}
+	if (count <= 0)
+		return;
+
+	write_reg32(adev, IO_ACX_SLV_MEM_CTL, 1); /* use autoincrement mode */
+	write_reg32(adev, IO_ACX_SLV_MEM_ADDR, source);
+	udelay (10);
 
+	/* destination may be unaligned, memcpy() sorts it out */
 	while (count >= 4) {
-		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, source);
-		udelay (10);
-		*((u32 *) destination) = read_reg32(adev, IO_ACX_SLV_MEM_DATA);
+		tmp = read_reg32(adev, IO_ACX_SLV_MEM_DATA);
+		memcpy(destination, &tmp, 4);
 		count -= 4;
-		source += 4;
 		destination += 4;
 	}
 
-	/*
-	 * If the word reads above didn't satisfy the count, read one
-	 * more word and transfer a byte at a time until the request
-	 * is satisfied.
-	 */
 	if (count) {
-		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, source);
-		udelay (10);
 		tmp = read_reg32(adev, IO_ACX_SLV_MEM_DATA);
-		while (count--) {
-			*destination++ = *ptmp++;
-		}
+		memcpy(destination, &tmp, count);
 	}
 
 }
@@ -229,54 +219,40 @@ void acxmem_copy_from_slavemem(acx_device_t *adev, u8 *destination,
 /*
  * Copy to slave memory
  *
- * TODO - rewrite using autoincrement, handle partial words
+ * Burst like acxmem_copy_from_slavemem(). A partial last word is
+ * merged into what the acx holds there, which needs the address set
+ * again for the read and for the write back.
  */
 /* = static */
 void acxmem_copy_to_slavemem(acx_device_t *adev, u32 destination,
 			u8 *source, int count)
 {
-	u32 tmp = 0;
-	u8* ptmp = (u8 *) &tmp;
-	static u8 src[512]; /* make static to avoid huge stack objects */
+	u32 tmp;
 
 	ACXMEM_WARN_NOT_SPIN_LOCKED;
 
-	/*
-	 * For now, make sure the source is word-aligned by copying it
-	 * to a word-aligned buffer.  Someday rewrite to avoid the
-	 * extra copy.
-	 */
-	if (count > sizeof(src)) {
-		pr_acx("copy_to_slavemem: Warning! buffer overflow!\n");
-		count = sizeof(src);
-	}
-	memcpy(src, source, count);
-	source = src;
+	if (count <= 0)
+		return;
 
+	write_reg32(adev, IO_ACX_SLV_MEM_CTL, 1); /* use autoincrement mode */
+	write_reg32(adev, IO_ACX_SLV_MEM_ADDR, destination);
+	udelay (10);
+
+	/* source may be unaligned, memcpy() sorts it out */
 	while (count >= 4) {
-		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, destination);
-		udelay (10);
-		write_reg32(adev, IO_ACX_SLV_MEM_DATA, *((u32 *) source));
+		memcpy(&tmp, source, 4);
+		write_reg32(adev, IO_ACX_SLV_MEM_DATA, tmp);
 		count -= 4;
 		source += 4;
 		destination += 4;
 	}
 
-	/*
-	 * If there are leftovers read the next word from the acx and
-	 * merge in what they want to write.
-	 */
 	if (count) {
 		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, destination);
 		udelay (10);
 		tmp = read_reg32(adev, IO_ACX_SLV_MEM_DATA);
-		while (count--) {
-			*ptmp++ = *source++;
-		}
-		/*
-		 * reset address in case we're currently in
-		 * auto-increment mode
-		 */
+		memcpy(&tmp, source, count);
+
 		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, destination);
 		udelay (10);
 		write_reg32(adev, IO_ACX_SLV_MEM_DATA, tmp);
@@ -295,29 +271,19 @@ void acxmem_chaincopy_to_slavemem(acx_device_t *adev, u32 destination,
 				u8 *source, int count)
 {
 	u32 val;
-	u32 *data = (u32 *) source;
-	static u8 aligned_source[WLAN_A4FR_MAXLEN_WEP_FCS];
 
 	ACXMEM_WARN_NOT_SPIN_LOCKED;
 
 	/*
-	 * Warn if the pointers don't look right.  Destination must
-	 * fit in [23:5] with zero elsewhere and source should be 32
-	 * bit aligned.  This should never happen since we're in
-	 * control of both, but I want to know about it if it does.
+	 * Warn if the pointer doesn't look right.  Destination must
+	 * fit in [23:5] with zero elsewhere.  This should never
+	 * happen since we're in control of it, but I want to know
+	 * about it if it does.
 	 */
 	if ((destination & 0x00ffffe0) != destination) {
 		pr_acx("chaincopy: destination block 0x%04x not aligned!\n",
 			destination);
 	}
-	if (count > sizeof aligned_source) {
-		pr_err("chaincopy_to_slavemem overflow!\n");
-		count = sizeof aligned_source;
-	}
-	if ((uintptr_t) source & 3) {
-		memcpy(aligned_source, source, count);
-		data = (u32 *) aligned_source;
-	}
 
 	/*
 	 * SLV_MEM_CTL[17:16] = memory block chain mode with
@@ -341,14 +307,21 @@ void acxmem_chaincopy_to_slavemem(acx_device_t *adev, u32 destination,
 	acx_writel (val, adev->iobase + ACX_SLV_MEM_ADDR);
 
 	/*
-	 * Write the data to the slave data register, rounding up to
-	 * the end of the word containing the last byte (hence the >
-	 * 0)
+	 * Write the data to the slave data register, padding the word
+	 * containing the last byte.  The source may be unaligned, the
+	 * memcpy()s take care of it without a bounce buffer.
 	 */
-	while (count > 0) {
-		acx_writel (*data++, adev->iobase + ACX_SLV_MEM_DATA);
+	while (count >= 4) {
+		memcpy(&val, source, 4);
+		acx_writel (val, adev->iobase + ACX_SLV_MEM_DATA);
+		source += 4;
 		count -= 4;
 	}
+	if (count > 0) {
+		val = 0;
+		memcpy(&val, source, count);
+		acx_writel (val, adev->iobase + ACX_SLV_MEM_DATA);
+	}
 
 }
 
@@ -363,30 +336,17 @@ void acxmem_chaincopy_from_slavemem(acx_device_t *adev, u8 *destination,
 				u32 source, int count)
 {
 	u32 val;
-	u32 *data = (u32 *) destination;
-	static u8 aligned_destination[WLAN_A4FR_MAXLEN_WEP_FCS];
-	int saved_count = count;
 
 	ACXMEM_WARN_NOT_SPIN_LOCKED;
 
 	/*
-	 * Warn if the pointers don't look right.  Destination must
-	 * fit in [23:5] with zero elsewhere and source should be 32
-	 * bit aligned.  Turns out the network stack sends unaligned
-	 * things, so fix them before copying to the ACX.
+	 * Warn if the pointer doesn't look right.  Source must fit in
+	 * [23:5] with zero elsewhere.
 	 */
 	if ((source & 0x00ffffe0) != source) {
 		pr_acx("chaincopy: source block 0x%04x not aligned!\n", source);
 		acxmem_dump_mem(adev, 0, 0x10000);
 	}
-	if ((uintptr_t) destination & 3) {
-		/* printk ("acx chaincopy: data destination not word aligned!\n"); */
-		data = (u32 *) aligned_destination;
-		if (count > sizeof aligned_destination) {
-			pr_err("chaincopy_from_slavemem overflow!\n");
-			count = sizeof aligned_destination;
-		}
-	}
 
 	/*
 	 * SLV_MEM_CTL[17:16] = memory block chain mode with auto-increment
@@ -409,21 +369,21 @@ void acxmem_chaincopy_from_slavemem(acx_device_t *adev, u8 *destination,
 	acx_writel (val, adev->iobase + ACX_SLV_MEM_ADDR);
 
 	/*
-	 * Read the data from the slave data register, rounding up to
-	 * the end of the word containing the last byte (hence the >
-	 * 0)
+	 * Read the data from the slave data register, the word
+	 * containing the last byte included.  The destination may be
+	 * unaligned, turns out the network stack hands out such
+	 * buffers; the memcpy()s take care of it without a bounce
+	 * buffer, and don't write past count.
 	 */
-	while (count > 0) {
-		*data++ = acx_readl (adev->iobase + ACX_SLV_MEM_DATA);
+	while (count >= 4) {
+		val = acx_readl (adev->iobase + ACX_SLV_MEM_DATA);
+		memcpy(destination, &val, 4);
+		destination += 4;
 		count -= 4;
 	}
-
-	/*
-	 * If the destination wasn't aligned, we would have saved it
-	 * in the aligned buffer, so copy it where it should go.
-	 */
-	if ((uintptr_t) destination & 3) {
-		memcpy(destination, aligned_destination, saved_count);
+	if (count > 0) {
+		val = acx_readl (adev->iobase + ACX_SLV_MEM_DATA);
+		memcpy(destination, &val, count);
 	}
 }
 
@@ -504,7 +464,7 @@ acxmem_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 		goto bad;
 	}
 
-	if ((acx_debug & L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
+	if (acx_debug_enabled(L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
 		pr_acxmem("input buffer (len=%u):\n", buflen);
 		acx_dump_bytes(buffer, buflen);
 	}
@@ -645,7 +605,7 @@ acxmem_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 	/* read in result parameters if needed */
 	if (buffer && buflen && (cmd == ACX1xx_CMD_INTERROGATE)) {
 		acxmem_copy_from_slavemem(adev, buffer, (uintptr_t) (adev->cmd_area + 4), buflen);
-		if (acx_debug & L_DEBUG) {
+		if (acx_debug_enabled(L_DEBUG)) {
 			log(L_ANY, "output buffer (len=%u): ", buflen);
 			acx_dump_bytes(buffer, buflen);
 		}
@@ -748,7 +708,7 @@ int acxmem_patch_around_bad_spots(acx_device_t *adev)
 	u32 offset;
 	int i;
 
-	firmware_image_t *fw_image = adev->fw_image;
+	const firmware_image_t *fw_image = adev->fw_image;
 
 	acxmem_lock_flags;
 
@@ -877,7 +837,7 @@ int acxmem_dbgfs_diag_output(struct seq_file *file,
 	seq_printf(file, "** Rx buf **\n");
 	rxdesc = adev->hw_rx_queue.acxdescinfo.start;
 	if (rxdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			rtl = (i == adev->hw_rx_queue.tail) ? " [tail]" : "";
 			Ctl_8 = read_slavemem8(adev, (uintptr_t)
 					&(rxdesc->Ctl_8));
@@ -924,7 +884,7 @@ int acxmem_dbgfs_diag_output(struct seq_file *file,
 
 	txdesc = adev->hw_tx_queue[0].acxdescinfo.start;
 	if (txdesc) {
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 			thd = (i == adev->hw_tx_queue[0].head) ? " [head]" : "";
 			ttl = (i == adev->hw_tx_queue[0].tail) ? " [tail]" : "";
 			acxmem_copy_from_slavemem(adev, (u8 *) &txd,
@@ -1047,15 +1007,22 @@ int acxmem_dbgfs_diag_output(struct seq_file *file,
  * ==================================================
  */
 
-void acxmem_process_rxdesc(acx_device_t *adev)
+/*
+ * Processes at most budget filled rx descriptors and returns how many
+ * were handled.
+ */
+int acxmem_process_rxdesc(acx_device_t *adev, int budget)
 {
 	rxhostdesc_t *hostdesc;
 	rxacxdesc_t *rxdesc;
+	/* host copy of the *rxdesc fields, see below */
+	rxacxdesc_t rxd;
 	unsigned count, tail;
 	u32 addr;
 	u8 Ctl_8;
+	int done = 0;
 
-	if (unlikely(acx_debug & L_BUFR))
+	if (unlikely(acx_debug_enabled(L_BUFR)))
 		acx_log_rxbuffer(adev);
 
 	/* First, have a loop to determine the first descriptor that's
@@ -1063,12 +1030,12 @@ void acxmem_process_rxdesc(acx_device_t *adev)
 	 * rx_tail and the full descriptor we're supposed to
 	 * handle. */
 	tail = adev->hw_rx_queue.tail;
-	count = RX_CNT;
+	count = adev->rx_cnt;
 	while (1) {
 		hostdesc = &adev->hw_rx_queue.hostdescinfo.start[tail];
 		rxdesc = &adev->hw_rx_queue.acxdescinfo.start[tail];
 		/* advance tail regardless of outcome of the below test */
-		tail = (tail + 1) % RX_CNT;
+		tail = (tail + 1) % adev->rx_cnt;
 
 		/*
 		 * Unlike the PCI interface, where the ACX can write
@@ -1080,7 +1047,7 @@ void acxmem_process_rxdesc(acx_device_t *adev)
 		 */
 		Ctl_8 = hostdesc->hd.Ctl_16
 			= read_slavemem8(adev, (uintptr_t) &(rxdesc->Ctl_8));
-					
+
 		if ((Ctl_8 & DESC_CTL_HOSTOWN) && (Ctl_8 & DESC_CTL_ACXDONE))
 			break; /* found it! */
 
@@ -1101,9 +1068,17 @@ void acxmem_process_rxdesc(acx_device_t *adev)
 		if (!(Ctl_8 & DESC_CTL_RECLAIM)) {
 			/*
 			 * slave interface - pull data now
+			 *
+			 * The fields the acx fills in before it sets
+			 * ACXDONE, ACXMemPtr to total_length, come over
+			 * in one burst, and only once Ctl_8 said so;
+			 * read ahead of Ctl_8 they may be stale.
 			 */
-			hostdesc->hd.length = read_slavemem16(adev,
-					(uintptr_t) &(rxdesc->total_length));
+			acxmem_copy_from_slavemem(adev, (u8 *) &rxd.ACXMemPtr,
+				(uintptr_t) &(rxdesc->ACXMemPtr),
+				offsetof(rxacxdesc_t, WEP_ofs)
+				- offsetof(rxacxdesc_t, ACXMemPtr));
+			hostdesc->hd.length = rxd.total_length;
 
 			/*
 			 * hostdesc->data is an rxbuffer_t, which
@@ -1112,8 +1087,7 @@ void acxmem_process_rxdesc(acx_device_t *adev)
 			 * information takes up an additional 12
 			 * bytes, so add that to the length we copy.
 			 */
-			addr = read_slavemem32(adev,
-					(uintptr_t) &(rxdesc->ACXMemPtr));
+			addr = rxd.ACXMemPtr.v;
 			if (addr) {
 				/*
 				 * How can &(rxdesc->ACXMemPtr) above
@@ -1153,21 +1127,26 @@ void acxmem_process_rxdesc(acx_device_t *adev)
 		 */
 		write_reg16(adev, IO_ACX_INT_TRIG, INT_TRIG_RXPRC);
 
+		if (++done >= budget)
+			break;
+
 		/* ok, descriptor is handled, now check the next descriptor */
 		hostdesc = &adev->hw_rx_queue.hostdescinfo.start[tail];
 		rxdesc = &adev->hw_rx_queue.acxdescinfo.start[tail];
 
-		Ctl_8 = hostdesc->hd.Ctl_16 = read_slavemem8(adev, (uintptr_t) &(rxdesc->Ctl_8));
+		Ctl_8 = hostdesc->hd.Ctl_16
+			= read_slavemem8(adev, (uintptr_t) &(rxdesc->Ctl_8));
 
 		/* if next descriptor is empty, then bail out */
 		if (!(Ctl_8 & DESC_CTL_HOSTOWN) || !(Ctl_8 & DESC_CTL_ACXDONE))
 			break;
 
-		tail = (tail + 1) % RX_CNT;
+		tail = (tail + 1) % adev->rx_cnt;
 	}
 	end:
 		adev->hw_rx_queue.tail = tail;
 
+	return done;
 }
 
 static int acxmem_get_txbuf_space_needed(acx_device_t *adev,
@@ -1182,12 +1161,23 @@ static int acxmem_get_txbuf_space_needed(acx_device_t *adev,
 	return (blocks_needed);
 }
 
+/* Host copy of the link word of an acx tx buffer block */
+static inline u32 *acxmem_txbuf_link(acx_device_t *adev, u32 block)
+{
+	return &adev->acx_txbuf_links[(block - adev->acx_txbuf_start)
+				/ adev->memblocksize];
+}
+
 /*
  * Return an acx pointer to the next transmit data block.
+ *
+ * The blocks taken from the head of the free list are already chained
+ * on the acx, by the free list itself. Only the last one needs its
+ * link word rewritten, to mark the end of the allocation.
  */
 u32 acxmem_allocate_acx_txbuf_space(acx_device_t *adev, int count)
 {
-	u32 block, next, last_block;
+	u32 block, last_block;
 	int blocks_needed;
 
 	/*
@@ -1196,42 +1186,29 @@ u32 acxmem_allocate_acx_txbuf_space(acx_device_t *adev, int count)
 	 */
 	blocks_needed = acxmem_get_txbuf_space_needed(adev, count);
 
-	if (blocks_needed <= adev->acx_txbuf_blocks_free) {
+	if (blocks_needed && blocks_needed <= adev->acx_txbuf_blocks_free) {
 		/*
-		 * Take blocks at the head of the free list.
+		 * Take blocks at the head of the free list, follow
+		 * the host copy of the block pointers to the last
+		 * block of the allocation.
 		 */
 		last_block = block = adev->acx_txbuf_free;
+		adev->acx_txbuf_blocks_free -= blocks_needed;
+		while (--blocks_needed)
+			last_block = (*acxmem_txbuf_link(adev, last_block)
+				& 0x7ffff) << 5;
 
 		/*
-		 * Follow block pointers through the requested number
-		 * of blocks both to find the new head of the free
-		 * list and to set the flags for the blocks
-		 * appropriately.
+		 * Update the new head of the free list
 		 */
-		while (blocks_needed--) {
-			/*
-			 * Keep track of the last block of the allocation
-			 */
-			last_block = adev->acx_txbuf_free;
-
-			/*
-			 * Make sure the end control flag is not set.
-			 */
-			next = read_slavemem32(adev, adev->acx_txbuf_free) & 0x7ffff;
-			write_slavemem32(adev, adev->acx_txbuf_free, next);
-
-			/*
-			 * Update the new head of the free list
-			 */
-			adev->acx_txbuf_free = next << 5;
-			adev->acx_txbuf_blocks_free--;
-
-		}
+		adev->acx_txbuf_free =
+			(*acxmem_txbuf_link(adev, last_block) & 0x7ffff) << 5;
 
 		/*
 		 * Flag the last block both by clearing out the next
 		 * pointer and marking the control field.
 		 */
+		*acxmem_txbuf_link(adev, last_block) = 0x02000000;
 		write_slavemem32(adev, last_block, 0x02000000);
 
 		/*
@@ -1257,6 +1234,7 @@ u32 acxmem_allocate_acx_txbuf_space(acx_device_t *adev, int count)
  * descriptor return it to its original state and move the queue head
  * pointer back.
  *
+ * Called with acxmem_lock held, see acx_tx_queue_go().
  */
 void acxmem_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque) {
 	/*
@@ -1266,9 +1244,6 @@ void acxmem_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque) {
 	txacxdesc_t tmptxdesc;
 	int index;
 
-	acxmem_lock_flags;
-	acxmem_lock();
-
 	memset (&tmptxdesc, 0, sizeof(tmptxdesc));
 	tmptxdesc.Ctl_8 = DESC_CTL_HOSTOWN | DESC_CTL_FIRSTFRAG;
 	tmptxdesc.u.r1.rate = 0x0a;
@@ -1289,9 +1264,6 @@ void acxmem_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque) {
 	pr_info("acx_dealloc: moving head from %d to %d\n",
 	        adev->hw_tx_queue[0].head, index);
 	adev->hw_tx_queue[0].head = index;
-
-	acxmem_unlock();
-
 }
 
 /*
@@ -1301,6 +1273,8 @@ void acxmem_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque) {
  * FIXME: in case of fragments, should allocate multiple descrs
  * after figuring out how many we need and whether we still have
  * sufficiently many.
+ *
+ * Called with acxmem_lock held, see acx_tx_queue_go().
  */
  /* OW TODO Align with pci.c */
 tx_t *acxmem_alloc_tx(acx_device_t *adev, unsigned int len) {
@@ -1309,12 +1283,8 @@ tx_t *acxmem_alloc_tx(acx_device_t *adev, unsigned int len) {
 	u8 ctl8;
 	static int txattempts = 0;
 	int blocks_needed;
-	acxmem_lock_flags;
-
 
-	acxmem_lock();
-
-	if (unlikely(!adev->hw_tx_queue[0].free)) {
+	if (unlikely(!acx_tx_free(adev, 0))) {
 		log(L_ANY, "BUG: no free txdesc left\n");
 		/*
 		 * Probably the ACX ignored a transmit attempt and now
@@ -1405,17 +1375,12 @@ tx_t *acxmem_alloc_tx(acx_device_t *adev, unsigned int len) {
 	/* Needed in case txdesc won't be eventually submitted for tx */
 	write_slavemem8(adev, (uintptr_t) &(txdesc->Ctl_8), DESC_CTL_ACXDONE_HOSTOWN);
 
-	adev->hw_tx_queue[0].free--;
-	log(L_BUFT, "tx: got desc %u, %u remain\n", head, adev->hw_tx_queue[0].free);
+	log(L_BUFT, "tx: got desc %u, %u remain\n", head, acx_tx_free(adev, 0) - 1);
 
 	/* returning current descriptor, so advance to next free one */
-	adev->hw_tx_queue[0].head = (head + 1) % TX_CNT;
+	adev->hw_tx_queue[0].head = (head + 1) % adev->tx_cnt;
 
 	end:
-
-	acxmem_unlock();
-
-
 	return (tx_t*) txdesc;
 }
 
@@ -1437,7 +1402,7 @@ void acxmem_reclaim_acx_txbuf_space(acx_device_t *adev, u32 blockptr)
 		cur = blockptr;
 		do {
 			last = cur;
-			next = read_slavemem32(adev, cur);
+			next = *acxmem_txbuf_link(adev, cur);
 
 			/*
 			 * Advance to the next block in this allocation
@@ -1458,11 +1423,12 @@ void acxmem_reclaim_acx_txbuf_space(acx_device_t *adev, u32 blockptr)
 		 * free blocks, make sure the new end of the list
 		 * marks itself as truly the end.
 		 */
-		if (adev->acx_txbuf_free) {
-			write_slavemem32(adev, last, adev->acx_txbuf_free >> 5);
-		} else {
-			write_slavemem32(adev, last, 0x02000000);
-		}
+		if (adev->acx_txbuf_free)
+			next = adev->acx_txbuf_free >> 5;
+		else
+			next = 0x02000000;
+		*acxmem_txbuf_link(adev, last) = next;
+		write_slavemem32(adev, last, next);
 		adev->acx_txbuf_free = blockptr;
 	}
 
@@ -1484,6 +1450,8 @@ void acxmem_init_acx_txbuf(acx_device_t *adev)
 	 * rest of the bookeeping.
 	 */
 
+	int i;
+
 	adev->acx_txbuf_free = adev->acx_txbuf_start;
 	adev->acx_txbuf_blocks_free = adev->acx_txbuf_numblocks;
 
@@ -1493,7 +1461,16 @@ void acxmem_init_acx_txbuf(acx_device_t *adev)
 	 * end of the list.  That's how we want to see it, too, so
 	 * leave it alone.  This is only ever called after a firmware
 	 * reset, so the ACX memory is in the state we want.
+	 *
+	 * From here on the host copy of the link words is
+	 * authoritative: allocation and reclaim follow it and only
+	 * write the words they change to the acx.
 	 */
+	for (i = 0; i < adev->acx_txbuf_numblocks - 1; i++)
+		adev->acx_txbuf_links[i] = (adev->acx_txbuf_start
+			+ (i + 1) * adev->memblocksize) >> 5;
+	if (adev->acx_txbuf_numblocks)
+		adev->acx_txbuf_links[i] = 0x02000000;
 
 }
 
@@ -1511,12 +1488,13 @@ void acxmem_init_acx_txbuf2(acx_device_t *adev)
 
 		/* Last block is marked with 0x02000000 */
 		if (i == adev->acx_txbuf_numblocks - 1) {
-			write_slavemem32(adev, adr, 0x02000000);
+			adev->acx_txbuf_links[i] = 0x02000000;
 		}
 		/* Else write pointer to next block */
 		else {
-			write_slavemem32(adev, adr, (next_adr >> 5));
+			adev->acx_txbuf_links[i] = next_adr >> 5;
 		}
+		write_slavemem32(adev, adr, adev->acx_txbuf_links[i]);
 		adr = next_adr;
 	}
 
@@ -1536,7 +1514,7 @@ acxmem_get_txhostdesc(acx_device_t *adev, txacxdesc_t* txdesc)
 		return NULL;
 	}
 	index /= adev->tx.desc_size;
-	if (unlikely(ACX_DEBUG && (index >= TX_CNT))) {
+	if (unlikely(ACX_DEBUG && (index >= adev->tx_cnt))) {
 		pr_info("bad txdesc ptr %p\n", txdesc);
 		return NULL;
 	}
@@ -1702,7 +1680,7 @@ static irqreturn_t acxmem_interrupt(int irq, void *dev_id)
 			 * buffer if we go into acxmem_clean_txdesc()
 			 * at a time when we won't wakeup the net
 			 * queue in there for some reason...) */
-			if (adev->tx_free <= TX_START_CLEAN) {
+			if (adev->tx_free <= TX_START_CLEAN(adev)) {
 #if TX_CLEANUP_IN_SOFTIRQ
 				acx_schedule_task(adev, ACX_AFTER_IRQ_TX_CLEANUP);
 #else
@@ -1898,7 +1876,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw,
 	char fcserror[0x8];
 	char ratefallback[0x5];
 
-	if (!(acx_debug & (L_IOCTL | L_DEBUG)))
+	if (!acx_debug_enabled(L_IOCTL | L_DEBUG))
 		return OK;
 	/* using printk() since we checked debug flag already */
 
@@ -2053,7 +2031,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw,
 
 	/* loop over complete receive pool */
 	if (rxdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump internal rxdesc %d:\n"
 				"mem pos %p\n"
 				"next 0x%X\n"
@@ -2076,7 +2054,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw,
 
 		/* loop over complete receive pool */
 		if (rxhostdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump host rxdesc %d:\n"
 				"mem pos %p\n"
 				"buffer mem pos 0x%X\n"
@@ -2101,7 +2079,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw,
 
 		/* loop over complete transmit pool */
 		if (txdesc)
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 			pr_acx("\ndump internal txdesc %d:\n"
 				"size 0x%X\n"
 				"mem pos %p\n"
@@ -2133,7 +2111,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw,
 
 		/* loop over complete host send pool */
 		if (txhostdesc)
-		for (i = 0; i < TX_CNT * 2; i++) {
+		for (i = 0; i < adev->tx_cnt * 2; i++) {
 			pr_acx("\ndump host txdesc %d:\n"
 				"mem pos %p\n"
 				"buffer mem pos 0x%X\n"
@@ -2216,6 +2194,55 @@ int acx100mem_ioctl_set_phy_amp_bias(struct ieee80211_hw *hw,
  * ==================================================
  */
 
+/* The slow part of acxmem_probe(), see acx_probe_async() */
+static int acxmem_probe_finish(acx_device_t *adev)
+{
+	struct ieee80211_hw *hw = adev->hw;
+	int result = -EIO;
+
+	acx_get_hardware_info(adev);
+	if (acxmem_load_firmware(adev))
+		goto fail_load_firmware;
+
+	if (acx_reset_on_probe(adev))
+		goto fail_reset_on_probe;
+
+	/* Debug fs */
+	if (acx_debugfs_add_adev(adev))
+		goto fail_debugfs;
+
+	/* Init ieee80211_hw  */
+	acx_init_ieee80211(adev, hw);
+	hw->wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION)
+					| BIT(NL80211_IFTYPE_ADHOC);
+
+	if ((result = ieee80211_register_hw(hw)))
+	{
+		pr_acx("ieee80211_register_hw() FAILED: %d\n", result);
+		goto fail_ieee80211_register_hw;
+	}
+
+#if CMD_DISCOVERY
+	great_inquisitor(adev);
+#endif
+
+	return OK;
+
+
+	/* error paths: undo everything in reverse order... */
+	fail_ieee80211_register_hw:
+	acx_debugfs_remove_adev(adev);
+
+	fail_debugfs:
+
+	fail_reset_on_probe:
+
+	fail_load_firmware:
+	acx_free_firmware(adev);
+
+	return result;
+}
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 8, 0)
 static int __devinit acxmem_probe(struct platform_device *pdev)
 #else
@@ -2326,46 +2353,13 @@ static int acxmem_probe(struct platform_device *pdev)
 	/** done with board specific setup **/
 
 	/* --- */
-	acx_get_hardware_info(adev);
-	if (acxmem_load_firmware(adev))
-		goto fail_load_firmware;
-
-	if (acx_reset_on_probe(adev))
-		goto fail_reset_on_probe;
-
-	/* Debug fs */
-	if (acx_debugfs_add_adev(adev))
-		goto fail_debugfs;
-
-	/* Init ieee80211_hw  */
-	acx_init_ieee80211(adev, hw);
-	hw->wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION)
-					| BIT(NL80211_IFTYPE_ADHOC);
-
-	if ((result = ieee80211_register_hw(hw)))
-	{
-		pr_acx("ieee80211_register_hw() FAILED: %d\n", result);
-		goto fail_ieee80211_register_hw;
-	}
-
-#if CMD_DISCOVERY
-	great_inquisitor(adev);
-#endif
+	acx_probe_async(adev, acxmem_probe_finish);
 
 	result = OK;
 	goto done;
 
 
 	/* error paths: undo everything in reverse order... */
-	fail_ieee80211_register_hw:
-
-	fail_debugfs:
-
-	fail_reset_on_probe:
-
-	fail_load_firmware:
-	acx_free_firmware(adev);
-
 	fail_request_irq:
 	free_irq(adev->irq, adev);
 
@@ -2414,9 +2408,11 @@ static int acxmem_remove(struct platform_device *pdev)
 		goto end_no_lock;
 	}
 
-	/* Unregister ieee80211 device */
+	/* Unregister ieee80211 device, if acxmem_probe_finish() got
+	 * that far */
 	log(L_INIT, "removing device %s\n", wiphy_name(adev->hw->wiphy));
-	ieee80211_unregister_hw(adev->hw);
+	if (!acx_probe_wait(adev))
+		ieee80211_unregister_hw(adev->hw);
 
 	/* If device wasn't hot unplugged... */
 	if (acxmem_adev_present(adev)) {
@@ -2514,6 +2510,10 @@ static int acxmem_e_suspend(struct platform_device *pdev,
 	adev = hw2adev(hw);
 	pr_info("sus: adev %p\n", adev);
 
+	/* never came up, see acx_probe_async() */
+	if (acx_probe_wait(adev))
+		return OK;
+
 	acx_sem_lock(adev);
 
 	ieee80211_unregister_hw(hw); /* this one cannot sleep */
@@ -2554,6 +2554,9 @@ static int acxmem_e_resume(struct platform_device *pdev)
 	adev = hw2adev(hw);
 	pr_acx("rsm: got adev %p\n", adev);
 
+	if (acx_probe_wait(adev))
+		return OK;
+
 	acx_sem_lock(adev);
 
 	/*
@@ -42,7 +42,7 @@ u32 acxmem_allocate_acx_txbuf_space(acx_device_t *adev, int count);
 void acxmem_init_acx_txbuf(acx_device_t *adev);
 void acxmem_init_acx_txbuf2(acx_device_t *adev);
 
-void acxmem_process_rxdesc(acx_device_t *adev);
+int acxmem_process_rxdesc(acx_device_t *adev, int budget);
 
 int __init acxmem_init_module(void);
 void __exit acxmem_cleanup_module(void);
@@ -106,7 +106,8 @@ static inline void __exit acxmem_cleanup_module(void)
 
 static inline void acxmem_init_mboxes(acx_device_t *adev) { }
 
-static inline void acxmem_process_rxdesc(acx_device_t *adev) { };
+static inline int acxmem_process_rxdesc(acx_device_t *adev, int budget)
+{ return 0; }
 
 #endif /* defined(CONFIG_ACX_MAC80211_MEM) */
 #endif /* _MEM_H_ */
@@ -40,6 +40,7 @@
 #include <linux/pm.h>
 #include <linux/vmalloc.h>
 #include <linux/workqueue.h>
+#include <linux/hrtimer.h>
 #include <linux/nl80211.h>
 #include <linux/dma-mapping.h>
 
@@ -65,6 +66,8 @@
 #include "tx.h"
 #include "main.h"
 #include "boot.h"
+#include "bench.h"
+#include "trace.h"
 #include "interrupt-masks.h"
 
 #define RX_BUFFER_SIZE (sizeof(rxbuffer_t) + 32)
@@ -72,6 +75,12 @@
 /* from mem.c:98 */
 #define FW_NO_AUTO_INCREMENT 1
 
+/* PCI burst upload: posted auto-increment writes, flushed every
+ * FW_BURST_LEN bytes; validation spot checks one word per
+ * FW_SPOT_CHECK_STRIDE bytes */
+#define FW_BURST_LEN		4096
+#define FW_SPOT_CHECK_STRIDE	1024
+
 /* identical from pci.c, mem.c */
 irqreturn_t acx_interrupt(int irq, void *dev_id)
 {
@@ -120,6 +129,7 @@ irqreturn_t acx_interrupt(int irq, void *dev_id)
 	 * later in the tasklet. */
 	write_reg16(adev, IO_ACX_IRQ_MASK, HOST_INT_MASK_ALL);
 	write_flush(adev);
+	adev->coalesce.irqs++;
 	acx_schedule_task(adev, 0);
 
 	spin_unlock_irqrestore(&adev->spinlock, flags);
@@ -136,11 +146,11 @@ int acx_upload_radio(acx_device_t *adev)
 	acx_ie_memmap_t mm;
 	acx_cmd_radioinit_t radioinit;
 	int res = NOT_OK;
-	int try;
+	int try, fast;
 	u32 offset;
 	acxmem_lock_flags;
 
-	firmware_image_t *radio_image=adev->radio_image;
+	const firmware_image_t *radio_image=adev->radio_image;
 
 	if (!radio_image)
 		return OK;
@@ -151,12 +161,17 @@ int acx_upload_radio(acx_device_t *adev)
 	acx_issue_cmd(adev, ACX1xx_CMD_SLEEP, NULL, 0);
 
 	for (try = 1; try <= 5; try++) {
+		/* after a failure, the slow and careful way */
+		fast = (try == 1);
+
 		acxmem_lock();
-		res = acx_write_fw(adev, radio_image, offset);
+		res = acx_write_fw(adev, radio_image, offset,
+				fast && acx_fw_burst);
 		log(L_DEBUG|L_INIT, "acx_write_fw (radio): %d\n", res);
 
 		if (OK == res) {
-			res = acx_validate_fw(adev, radio_image, offset);
+			res = acx_validate_fw(adev, radio_image, offset,
+					!fast || acx_fw_validate);
 			log(L_DEBUG|L_INIT, "acx_validate_fw (radio): %d\n", res);
 		}
 		acxmem_unlock();
@@ -221,7 +236,7 @@ static inline void acx_free(acx_device_t *adev, size_t *size,
 	pr_info("size:%zu, vaddr:%p, dma_handle:%p\n", *size, *start, (void*) phy);
 
 	if (IS_PCI(adev))
-		dma_free_coherent(NULL, *size, *start, phy);
+		dma_free_coherent(adev->bus_dev, *size, *start, phy);
 	else
 		vfree(*start);
 
@@ -230,11 +245,90 @@ static inline void acx_free(acx_device_t *adev, size_t *size,
 }
 
 
+/*
+ * acx_rx_skb_map()
+ *
+ * Zero-copy rx: allocate an skb big enough for a whole rxbuffer_t and
+ * map it for the device.
+ */
+static struct sk_buff *acx_rx_skb_map(acx_device_t *adev, dma_addr_t *phy)
+{
+	struct sk_buff *skb;
+
+	skb = dev_alloc_skb(RX_BUFFER_SIZE);
+	if (!skb)
+		return NULL;
+
+	*phy = dma_map_single(adev->bus_dev, skb->data, RX_BUFFER_SIZE,
+			DMA_FROM_DEVICE);
+	if (dma_mapping_error(adev->bus_dev, *phy)) {
+		dev_kfree_skb(skb);
+		return NULL;
+	}
+
+	return skb;
+}
+
+static void acx_rx_skb_unmap_all(acx_device_t *adev)
+{
+	rxhostdesc_t *hostdesc = adev->hw_rx_queue.hostdescinfo.start;
+	int i;
+
+	if (!hostdesc)
+		return;
+
+	for (i = 0; i < adev->rx_cnt; i++, hostdesc++) {
+		if (!hostdesc->skb)
+			continue;
+		dma_unmap_single(adev->bus_dev, acx2cpu(hostdesc->hd.data_phy),
+				RX_BUFFER_SIZE, DMA_FROM_DEVICE);
+		dev_kfree_skb(hostdesc->skb);
+		hostdesc->skb = NULL;
+		hostdesc->data = NULL;
+	}
+}
+
+/*
+ * acx_process_rxdesc_skb()
+ *
+ * Hand the filled skb of a zero-copy rx hostdesc up the stack and map
+ * a fresh one into the slot. If no replacement can be allocated, the
+ * frame is copied out as usual and the old skb stays in the ring.
+ */
+void acx_process_rxdesc_skb(acx_device_t *adev, rxhostdesc_t *hostdesc)
+{
+	struct sk_buff *skb = hostdesc->skb;
+	struct sk_buff *new_skb;
+	dma_addr_t phy = acx2cpu(hostdesc->hd.data_phy);
+	dma_addr_t new_phy;
+
+	new_skb = acx_rx_skb_map(adev, &new_phy);
+	if (unlikely(!new_skb)) {
+		dma_sync_single_for_cpu(adev->bus_dev, phy, RX_BUFFER_SIZE,
+				DMA_FROM_DEVICE);
+		acx_process_rxbuf(adev, hostdesc->data);
+		dma_sync_single_for_device(adev->bus_dev, phy, RX_BUFFER_SIZE,
+				DMA_FROM_DEVICE);
+		return;
+	}
+
+	dma_unmap_single(adev->bus_dev, phy, RX_BUFFER_SIZE, DMA_FROM_DEVICE);
+
+	hostdesc->skb = new_skb;
+	hostdesc->data = (rxbuffer_t*) new_skb->data;
+	hostdesc->hd.data_phy = cpu2acx(new_phy);
+
+	acx_process_rxskb(adev, skb);
+}
+
 /*
  * acx_create_rx_host_desc_queue()
  *
  * the whole size of a data buffer (header plus data body) plus 32
  * bytes safety offset at the end
+ *
+ * On PCI with rxzerocopy=1 the hostdescs get one mapped skb each
+ * instead of a slice of the shared rx buffer pool.
  */
 static int acx_create_rx_host_desc_queue(acx_device_t *adev)
 {
@@ -248,7 +342,7 @@ static int acx_create_rx_host_desc_queue(acx_device_t *adev)
 
 	/* allocate the RX host descriptor queue pool, if not already done */
 	if (!adev->hw_rx_queue.hostdescinfo.start) {
-		adev->hw_rx_queue.hostdescinfo.size = RX_CNT * sizeof(*hostdesc);
+		adev->hw_rx_queue.hostdescinfo.size = adev->rx_cnt * sizeof(*hostdesc);
 		rc = acx_allocate(adev, adev->hw_rx_queue.hostdescinfo.size,
 			&adev->hw_rx_queue.hostdescinfo.phy,
 			(void**) &adev->hw_rx_queue.hostdescinfo.start, "rxhostdesc_start");
@@ -262,10 +356,12 @@ static int acx_create_rx_host_desc_queue(acx_device_t *adev)
 		goto fail;
 	}
 
+	adev->hw_rx_queue.zerocopy = IS_PCI(adev) && acx_rx_zerocopy;
+
 	/* allocate Rx buffer pool which will be used by the acx
 	 * to store the whole content of the received frames in it */
-	if (!adev->hw_rx_queue.bufinfo.start) {
-		adev->hw_rx_queue.bufinfo.size = RX_CNT * RX_BUFFER_SIZE;
+	if (!adev->hw_rx_queue.zerocopy && !adev->hw_rx_queue.bufinfo.start) {
+		adev->hw_rx_queue.bufinfo.size = adev->rx_cnt * RX_BUFFER_SIZE;
 		rc = acx_allocate(adev, adev->hw_rx_queue.bufinfo.size,
 			&adev->hw_rx_queue.bufinfo.phy,
 			&adev->hw_rx_queue.bufinfo.start, "rxbuf_start");
@@ -281,13 +377,25 @@ static int acx_create_rx_host_desc_queue(acx_device_t *adev)
 	/* don't make any popular C programming pointer arithmetic
 	 * mistakes here, otherwise I'll kill you...  (and don't dare
 	 * asking me why I'm warning you about that...) */
-	for (i = 0; i < RX_CNT; i++) {
-		hostdesc->data = rxbuf;
-		hostdesc->hd.data_phy = cpu2acx(rxbuf_phy);
+	for (i = 0; i < adev->rx_cnt; i++) {
+		if (adev->hw_rx_queue.zerocopy) {
+			if (!hostdesc->skb) {
+				hostdesc->skb = acx_rx_skb_map(adev, &rxbuf_phy);
+				if (!hostdesc->skb) {
+					rc = -ENOMEM;
+					goto fail;
+				}
+				hostdesc->data = (rxbuffer_t*) hostdesc->skb->data;
+				hostdesc->hd.data_phy = cpu2acx(rxbuf_phy);
+			}
+		} else {
+			hostdesc->data = rxbuf;
+			hostdesc->hd.data_phy = cpu2acx(rxbuf_phy);
+			rxbuf++;
+			rxbuf_phy += sizeof(*rxbuf);
+		}
 		hostdesc->hd.length = cpu_to_le16(RX_BUFFER_SIZE);
 		CLEAR_BIT(hostdesc->hd.Ctl_16, cpu_to_le16(DESC_CTL_HOSTOWN));
-		rxbuf++;
-		rxbuf_phy += sizeof(*rxbuf);
 		hostdesc_phy += sizeof(*hostdesc);
 		hostdesc->hd.desc_phy_next = cpu2acx(hostdesc_phy);
 		hostdesc++;
@@ -312,9 +420,11 @@ static int acx_create_tx_host_desc_queue(acx_device_t *adev, struct hw_tx_queue
 	dma_addr_t txbuf_phy;
 	int i, rc;
 
+	tx->zerocopy = IS_PCI(adev) && acx_tx_zerocopy;
+
 	/* allocate TX buffer, if not already done */
-	if (!tx->bufinfo.start) {
-		tx->bufinfo.size = TX_CNT * WLAN_A4FR_MAXLEN_WEP_FCS;
+	if (!tx->zerocopy && !tx->bufinfo.start) {
+		tx->bufinfo.size = adev->tx_cnt * WLAN_A4FR_MAXLEN_WEP_FCS;
 		rc = acx_allocate(adev, tx->bufinfo.size, &tx->bufinfo.phy,
 			&tx->bufinfo.start, "txbuf_start");
 		if (rc)
@@ -323,7 +433,7 @@ static int acx_create_tx_host_desc_queue(acx_device_t *adev, struct hw_tx_queue
 
 	/* allocate the TX host descriptor queue pool */
 	if (!tx->hostdescinfo.start) {
-		tx->hostdescinfo.size = TX_CNT * 2 * sizeof(*hostdesc);
+		tx->hostdescinfo.size = adev->tx_cnt * 2 * sizeof(*hostdesc);
 		rc = acx_allocate(adev, tx->hostdescinfo.size, &tx->hostdescinfo.phy,
 			(void**) &tx->hostdescinfo.start, "txhostdesc_start");
 		if (rc)
@@ -355,7 +465,7 @@ static int acx_create_tx_host_desc_queue(acx_device_t *adev, struct hw_tx_queue
  * WG311v2 is even more bogus, doesn't work.  Keeping this code
  * (#ifdef'ed out) for documentational purposes.
  */
-	for (i = 0; i < TX_CNT * 2; i++) {
+	for (i = 0; i < adev->tx_cnt * 2; i++) {
 		hostdesc_phy += sizeof(*hostdesc);
 		if (!(i & 1)) {
 			hostdesc->hd.data_phy = cpu2acx(txbuf_phy);
@@ -389,11 +499,11 @@ static int acx_create_tx_host_desc_queue(acx_device_t *adev, struct hw_tx_queue
 
 	/* We initialize two hostdescs so that they point to adjacent
 	 * memory areas. Thus txbuf is really just a contiguous memory
-	 * area */
-	for (i = 0; i < TX_CNT * 2; i++) {
+	 * area. With zero-copy tx, data_phy is filled per frame by
+	 * acx_tx_map_skb() instead. */
+	for (i = 0; i < adev->tx_cnt * 2; i++) {
 		hostdesc_phy += sizeof(*hostdesc);
 
-		hostdesc->hd.data_phy = cpu2acx(txbuf_phy);
 		/* done by memset(0): hostdesc->data_offset = 0; */
 		/* hostdesc->reserved = ... */
 		hostdesc->hd.Ctl_16 = cpu_to_le16(DESC_CTL_HOSTOWN);
@@ -401,6 +511,13 @@ static int acx_create_tx_host_desc_queue(acx_device_t *adev, struct hw_tx_queue
 		hostdesc->hd.desc_phy_next = cpu2acx(hostdesc_phy);
 		/* done by memset(0): hostdesc->pNext = ptr2acx(NULL); */
 		/* hostdesc->Status = ... */
+
+		if (tx->zerocopy) {
+			hostdesc++;
+			continue;
+		}
+
+		hostdesc->hd.data_phy = cpu2acx(txbuf_phy);
 		/* ->data is a non-hardware field: */
 		hostdesc->data = txbuf;
 
@@ -427,6 +544,38 @@ fail:
 	return NOT_OK;
 }
 
+/*
+ * acx_tx_unmap_skb()
+ *
+ * Zero-copy tx: release the dma mapping set up by acx_tx_map_skb().
+ * hostdesc is the first (header) hostdesc of the pair.
+ */
+static void acx_tx_unmap_skb(acx_device_t *adev, txhostdesc_t *hostdesc)
+{
+	dma_unmap_single(adev->bus_dev, acx2cpu(hostdesc->hd.data_phy),
+			hostdesc->skb->len, DMA_TO_DEVICE);
+	hostdesc->data = NULL;
+	(hostdesc + 1)->data = NULL;
+}
+
+/* Drop frames still sitting in a zero-copy tx ring on teardown */
+static void acx_tx_unmap_all(acx_device_t *adev, struct hw_tx_queue *tx)
+{
+	txhostdesc_t *hostdesc = tx->hostdescinfo.start;
+	int i;
+
+	if (!tx->zerocopy || !hostdesc)
+		return;
+
+	for (i = 0; i < adev->tx_cnt; i++, hostdesc += 2) {
+		if (!hostdesc->skb)
+			continue;
+		acx_tx_unmap_skb(adev, hostdesc);
+		dev_kfree_skb(hostdesc->skb);
+		hostdesc->skb = NULL;
+	}
+}
+
 int acx_create_hostdesc_queues(acx_device_t *adev, int num_tx)
 {
         int res;
@@ -466,7 +615,7 @@ static void acx_create_rx_desc_queue(acx_device_t *adev, u32 rx_queue_start)
 
 		rxdesc = adev->hw_rx_queue.acxdescinfo.start;
 
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			log(L_DEBUG, "rx descriptor %d @ 0x%p\n", i, rxdesc);
 
 			if (IS_PCI(adev))
@@ -484,7 +633,7 @@ static void acx_create_rx_desc_queue(acx_device_t *adev, u32 rx_queue_start)
 		/* rxdesc_start should be right AFTER Tx pool */
 		adev->hw_rx_queue.acxdescinfo.start = (rxacxdesc_t *)
 			((u8 *) adev->hw_tx_queue[0].acxdescinfo.start
-				+ (TX_CNT * sizeof(txacxdesc_t)));
+				+ (adev->tx_cnt * sizeof(txacxdesc_t)));
 
 		/* NB: sizeof(txdesc_t) above is valid because we know
 		 * we are in if (acx100) block. Beware of cut-n-pasting
@@ -492,11 +641,11 @@ static void acx_create_rx_desc_queue(acx_device_t *adev, u32 rx_queue_start)
 
 		if (IS_PCI(adev))
 			memset(adev->hw_rx_queue.acxdescinfo.start, 0,
-				RX_CNT * sizeof(*rxdesc));
+				adev->rx_cnt * sizeof(*rxdesc));
 		else { // IS_MEM
 			mem_offs = (uintptr_t) adev->hw_rx_queue.acxdescinfo.start;
 			while (mem_offs < (uintptr_t) adev->hw_rx_queue.acxdescinfo.start
-				+ (RX_CNT * sizeof(*rxdesc))) {
+				+ (adev->rx_cnt * sizeof(*rxdesc))) {
 				write_slavemem32(adev, mem_offs, 0);
 				mem_offs += 4;
 			}
@@ -504,7 +653,7 @@ static void acx_create_rx_desc_queue(acx_device_t *adev, u32 rx_queue_start)
 		/* loop over whole receive pool */
 		rxdesc = adev->hw_rx_queue.acxdescinfo.start;
 		mem_offs = rx_queue_start;
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			log(L_DEBUG, "rx descriptor @ 0x%p\n", rxdesc);
 			/* point to next rxdesc */
 			if (IS_PCI(adev)){
@@ -571,7 +720,10 @@ static void acx_create_tx_desc_queue(acx_device_t *adev, u32 tx_queue_start, int
 
 	adev->hw_tx_queue[queue_id].head = 0;
 	adev->hw_tx_queue[queue_id].tail = 0;
-	adev->hw_tx_queue[queue_id].free = TX_CNT;
+	adev->hw_tx_queue[queue_id].queued = 0;
+	adev->hw_tx_queue[queue_id].cleaned = 0;
+	memset(adev->hw_tx_queue[queue_id].lat_hist, 0,
+		sizeof(adev->hw_tx_queue[queue_id].lat_hist));
 
 	txdesc = tx->acxdescinfo.start;
 	if (IS_PCI(adev)) {
@@ -583,7 +735,7 @@ static void acx_create_tx_desc_queue(acx_device_t *adev, u32 tx_queue_start, int
 		/* ACX111 has a preinitialized Tx buffer! */
 		/* loop over whole send pool */
 		/* FIXME: do we have to do the hostmemptr stuff here?? */
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 
 			txdesc->Ctl_8 = DESC_CTL_HOSTOWN;
 			/* reserve two (hdr desc and payload desc) */
@@ -600,20 +752,20 @@ static void acx_create_tx_desc_queue(acx_device_t *adev, u32 tx_queue_start, int
 		 * acx100) */
 		if (IS_PCI(adev))
 			memset(tx->acxdescinfo.start, 0,
-				TX_CNT * sizeof(*txdesc));
+				adev->tx_cnt * sizeof(*txdesc));
 		else {
 			/* tx->desc_start refers to device memory,
 			  so we can't write directly to it. */
 			clr = (uintptr_t) tx->acxdescinfo.start;
 			while (clr < (uintptr_t) tx->acxdescinfo.start
-				+ (TX_CNT * sizeof(*txdesc))) {
+				+ (adev->tx_cnt * sizeof(*txdesc))) {
 				write_slavemem32(adev, clr, 0);
 				clr += 4;
 			}
 		}
 
 		/* loop over whole send pool */
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 			log(L_DEBUG, "configure card tx descriptor: 0x%p, "
 				"size: %zu\n", txdesc, tx->acxdescinfo.size);
 
@@ -706,6 +858,7 @@ void acx_free_desc_queues(acx_device_t *adev)
 	int i;
 
 	for (i = 0; i < adev->num_hw_tx_queues; i++) {
+		acx_tx_unmap_all(adev, &adev->hw_tx_queue[i]);
 		acx_free(adev, &adev->hw_tx_queue[i].hostdescinfo.size,
 		        (void**) &adev->hw_tx_queue[i].hostdescinfo.start,
 		        adev->hw_tx_queue[i].hostdescinfo.phy);
@@ -718,6 +871,7 @@ void acx_free_desc_queues(acx_device_t *adev)
 		adev->hw_tx_queue[i].acxdescinfo.size = 0;
 	}
 
+	acx_rx_skb_unmap_all(adev);
 	acx_free(adev, &adev->hw_rx_queue.hostdescinfo.size,
 	        (void**) &adev->hw_rx_queue.hostdescinfo.start,
 	        adev->hw_rx_queue.hostdescinfo.phy);
@@ -771,7 +925,7 @@ void acx_log_rxbuffer(const acx_device_t *adev)
 	if (unlikely(!rxhostdesc))
 		return;
 
-	for (i = 0; i < RX_CNT; i++) {
+	for (i = 0; i < adev->rx_cnt; i++) {
 		if ((rxhostdesc->hd.Ctl_16 & cpu_to_le16(DESC_CTL_HOSTOWN))
 		    && (rxhostdesc->hd.Status & cpu_to_le32(DESC_STATUS_FULL)))
 			pr_acx("rx: buf %d full\n", i);
@@ -790,7 +944,7 @@ void acx_log_txbuffer(acx_device_t *adev, int queue_id)
 			return;
 
 	pr_acx("tx[%d]: desc->Ctl8's: ", queue_id);
-	for (i = 0; i < TX_CNT; i++) {
+	for (i = 0; i < adev->tx_cnt; i++) {
 		Ctl_8 = (IS_MEM(adev))
 			? read_slavemem8(adev, (uintptr_t) &(txdesc->Ctl_8))
 			: txdesc->Ctl_8;
@@ -803,21 +957,7 @@ void acx_log_txbuffer(acx_device_t *adev, int queue_id)
 /* ####################################################################
  * BOM Firmware, EEPROM, Phy
  */
-/*
- * acx_read_eeprom_byte
- *
- * Function called to read an octet in the EEPROM.
- *
- * This function is used by acxmem_e_probe to check if the
- * connected card is a legal one or not.
- *
- * Arguments:
- *	adev		ptr to acx_device structure
- *	addr		address to read in the EEPROM
- *	charbuf		ptr to a char. This is where the read octet
- *			will be stored
- */
-int acx_read_eeprom_byte(acx_device_t *adev, u32 addr, u8 *charbuf)
+static int _acx_read_eeprom_byte(acx_device_t *adev, u32 addr, u8 *charbuf)
 {
 	int result;
 	int count;
@@ -853,6 +993,59 @@ fail:
 	return result;
 }
 
+/*
+ * acx_read_eeprom
+ *
+ * Every EEPROM byte costs a busy-wait on IO_ACX_EEPROM_CTL, so read
+ * all of it once at probe time and serve acx_read_eeprom_byte(), the
+ * card id check and the debugfs view from the copy. acx_write_eeprom()
+ * drops it. Called without the acxmem_lock: it is taken per byte, so
+ * the mem device doesn't spin through all of the EEPROM with irqs off.
+ */
+int acx_read_eeprom(acx_device_t *adev)
+{
+	int i, res;
+	acxmem_lock_flags;
+
+	adev->eeprom_cached = 0;
+
+	for (i = 0; i < ACX_EEPROM_SIZE; i++) {
+		acxmem_lock();
+		res = _acx_read_eeprom_byte(adev, i, &adev->eeprom[i]);
+		acxmem_unlock();
+		if (OK != res)
+			return NOT_OK;
+	}
+
+	adev->eeprom_cached = 1;
+
+	return OK;
+}
+
+/*
+ * acx_read_eeprom_byte
+ *
+ * Function called to read an octet in the EEPROM.
+ *
+ * This function is used by acxmem_e_probe to check if the
+ * connected card is a legal one or not.
+ *
+ * Arguments:
+ *	adev		ptr to acx_device structure
+ *	addr		address to read in the EEPROM
+ *	charbuf		ptr to a char. This is where the read octet
+ *			will be stored
+ */
+int acx_read_eeprom_byte(acx_device_t *adev, u32 addr, u8 *charbuf)
+{
+	if (adev->eeprom_cached && addr < ACX_EEPROM_SIZE) {
+		*charbuf = adev->eeprom[addr];
+		return OK;
+	}
+
+	return _acx_read_eeprom_byte(adev, addr, charbuf);
+}
+
 char *acx_proc_eeprom_output(int *length, acx_device_t *adev)
 {
 	char *p, *buf;
@@ -860,16 +1053,23 @@ char *acx_proc_eeprom_output(int *length, acx_device_t *adev)
 	acxmem_lock_flags;
 
 
-	acxmem_lock();
+	p = buf = kmalloc(ACX_EEPROM_SIZE, GFP_KERNEL);
+	if (!buf)
+		return NULL;
 
-	p = buf = kmalloc(0x400, GFP_KERNEL);
-	for (i = 0; i < 0x400; i++) {
+	if (adev->eeprom_cached) {
+		memcpy(buf, adev->eeprom, ACX_EEPROM_SIZE);
+		*length = ACX_EEPROM_SIZE;
+		return buf;
+	}
+
+	for (i = 0; i < ACX_EEPROM_SIZE; i++) {
+		acxmem_lock();
 		acx_read_eeprom_byte(adev, i, p++);
+		acxmem_unlock();
 	}
 	*length = i;
 
-	acxmem_unlock();
-
 	return buf;
 }
 
@@ -909,6 +1109,9 @@ int acx_write_eeprom(acx_device_t *adev, u32 addr, u32 len,
 	write_reg16(adev, IO_ACX_GPIO_OE, gpio_orig & ~1);
 	write_flush(adev);
 
+	/* the copy is stale from here on, see acx_read_eeprom() */
+	adev->eeprom_cached = 0;
+
 	/* ok, now start writing the data out */
 	for (i = 0; i < len; i++) {
 		write_reg32(adev, IO_ACX_EEPROM_CFG, 0);
@@ -975,7 +1178,7 @@ static inline void acx_read_eeprom_area(acx_device_t *adev)
 
 	if (IS_MEM(adev) || IS_PCI(adev))
 		for (offs = 0x8c; offs < 0xb9; offs++)
-			acx_read_eeprom_byte(adev, offs, &tmp);
+			_acx_read_eeprom_byte(adev, offs, &tmp);
 	else
 		BUG();
 
@@ -1085,6 +1288,8 @@ fail:
  * Arguments:
  *	adev		wlan device structure
  *	fw_image	firmware image.
+ *	offset		where to put it in card memory
+ *	burst		PCI: stream it with auto-increment, see acx_fw_burst
  *
  * Returns:
  *	1	firmware image corrupted
@@ -1093,7 +1298,7 @@ fail:
 /* static  */
 #if 1	// acx_write_fw()
 int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
-		u32 offset)
+		u32 offset, int burst)
 {
 	int len, size;
 	u32 sum, v32;
@@ -1121,6 +1326,11 @@ int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 #endif	/* FW_NO_AUTO_INCREMENT */
 #endif	/* NOPE mem.c only, all else same */
 	}
+	else if (burst) {
+		write_reg32(adev, IO_ACX_SLV_MEM_CTL, 1); /* use autoincrement mode */
+		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, offset); /* configure start address */
+		write_flush(adev);
+	}
 	else {
 #if FW_NO_AUTO_INCREMENT
 		write_reg32(adev, IO_ACX_SLV_MEM_CTL, 0); /* use basic mode */
@@ -1139,7 +1349,12 @@ int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 		p += 4;
 		len += 4;
 
-		if (IS_PCI(adev)) {
+		if (IS_PCI(adev) && burst) {
+			/* no flush per word, the writes are posted */
+			write_reg32(adev, IO_ACX_SLV_MEM_DATA, v32);
+			if (!(len % FW_BURST_LEN))
+				write_flush(adev);
+		} else if (IS_PCI(adev)) {
 #if FW_NO_AUTO_INCREMENT
 			write_reg32(adev, IO_ACX_SLV_MEM_ADDR,
 				offset + len - 4);
@@ -1175,6 +1390,9 @@ int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 
 	} // while (likely(len < size)
 
+	if (IS_PCI(adev) && burst)
+		write_flush(adev);
+
 	log(L_DEBUG, "firmware written, size:%d sum1:%x sum2:%x\n",
 		size, sum, le32_to_cpu(fw_image->chksum));
 
@@ -1184,11 +1402,61 @@ int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 }
 #endif	// acx_write_fw()
 
+/* One word of the firmware image, at byte pos, as in card memory */
+static int acx_spot_check_fw_word(acx_device_t *adev,
+				const firmware_image_t *fw_image,
+				u32 offset, int pos)
+{
+	u32 v32, w32;
+
+	v32 = be32_to_cpu(*(u32 *) &fw_image->data[pos]);
+
+	if (IS_PCI(adev)) {
+		write_reg32(adev, IO_ACX_SLV_MEM_ADDR, offset + pos);
+		w32 = read_reg32(adev, IO_ACX_SLV_MEM_DATA);
+	} else
+		w32 = read_slavemem32(adev, offset + pos);
+
+	if (unlikely(w32 != v32)) {
+		pr_acx("FATAL: firmware upload: "
+			"spot check at offset %d failed (0x%08X vs. 0x%08X)\n",
+			pos, v32, w32);
+		return NOT_OK;
+	}
+	return OK;
+}
+
 /*
- * Compare the firmware image given with the firmware image written into the card.
+ * The quick alternative to the full readback: acx_write_fw() already
+ * verified the image checksum, so only make sure that the words
+ * landed where they belong, one per FW_SPOT_CHECK_STRIDE bytes and the
+ * last one.
+ */
+static int acx_spot_check_fw(acx_device_t *adev,
+			const firmware_image_t *fw_image, u32 offset)
+{
+	int size = le32_to_cpu(fw_image->size) & (~3);
+	int pos;
+
+	if (!size)
+		return OK;
+
+	write_reg32(adev, IO_ACX_SLV_END_CTL, 0);
+	write_reg32(adev, IO_ACX_SLV_MEM_CTL, 0); /* use basic mode */
+
+	for (pos = 0; pos < size; pos += FW_SPOT_CHECK_STRIDE)
+		if (acx_spot_check_fw_word(adev, fw_image, offset, pos))
+			return NOT_OK;
+
+	return acx_spot_check_fw_word(adev, fw_image, offset, size - 4);
+}
+
+/*
+ * Compare the firmware image given with the firmware image written
+ * into the card: word by word if full, else spot checks only.
  */
 int acx_validate_fw(acx_device_t *adev, const firmware_image_t *fw_image,
-		u32 offset)
+		u32 offset, int full)
 {
 	u32 sum, v32, w32;
 	int len, size;
@@ -1196,6 +1464,9 @@ int acx_validate_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 	/* we skip the first four bytes which contain the control sum */
 	const u8 *p = (u8*) fw_image + 4;
 
+	if (!full)
+		return acx_spot_check_fw(adev, fw_image, offset);
+
 	/* start the image checksum by adding the image size value */
 	sum = p[0] + p[1] + p[2] + p[3];
 	p += 4;
@@ -1266,19 +1537,22 @@ int acx_validate_fw(acx_device_t *adev, const firmware_image_t *fw_image,
 static int _acx_upload_fw(acx_device_t *adev)
 {
 	int res = NOT_OK;
-	int try;
+	int try, fast;
 
-	firmware_image_t *fw_image = adev->fw_image;
+	const firmware_image_t *fw_image = adev->fw_image;
 
 	acxmem_lock_flags;
 
 	for (try = 1; try <= 5; try++) {
+		/* after a failure, the slow and careful way */
+		fast = (try == 1);
 
 		acxmem_lock();
-		res = acx_write_fw(adev, fw_image, 0);
+		res = acx_write_fw(adev, fw_image, 0, fast && acx_fw_burst);
 		log(L_DEBUG|L_INIT, "acx_write_fw (main): %d\n", res);
 		if (OK == res) {
-			res = acx_validate_fw(adev, fw_image, 0);
+			res = acx_validate_fw(adev, fw_image, 0,
+					!fast || acx_fw_validate);
 			log(L_DEBUG|L_INIT, "acx_validate_fw "
 					"(main): %d\n", res);
 		}
@@ -1302,12 +1576,10 @@ static int _acx_upload_fw(acx_device_t *adev)
 
 int acx_free_firmware(acx_device_t *adev)
 {
-	if(adev->fw_image)
-		vfree(adev->fw_image);
+	acx_release_fw(adev->fw_image);
 	adev->fw_image = NULL;
 
-	if(adev->radio_image)
-		vfree(adev->radio_image);
+	acx_release_fw(adev->radio_image);
 	adev->radio_image = NULL;
 
 	return 0;
@@ -1434,7 +1706,7 @@ static inline void acx_show_card_eeprom_id(acx_device_t *adev) {}
 static int acx_wait_cmd_status(acx_device_t *adev, unsigned cmd,
 			void *buffer, unsigned buflen,
 			unsigned cmd_timeout, const char *cmdstr,
-			const char *devname)
+			const char *devname, unsigned long flags)
 {
 	unsigned counter;
 	u16 cmd_status = -1;
@@ -1446,11 +1718,10 @@ static int acx_wait_cmd_status(acx_device_t *adev, unsigned cmd,
 		if (!cmd_status)
 			break;
 
-		if (IS_MEM(adev))
-			// mem under lock, may not sleep
-			udelay(1000);
-		else 	// pci not under lock, may sleep
-			acx_mwait(1);
+		/* mem: don't spin under the lock with irqs off */
+		acxmem_unlock();
+		acx_mwait(1);
+		acxmem_lock();
 
 	} while (likely(--counter));
 
@@ -1493,6 +1764,15 @@ static int acx_wait_cmd_status(acx_device_t *adev, unsigned cmd,
  *
  * Also ifup/down works more reliable on the mem device.
  *
+ * The data accesses are still all done under the spinlock, but it is
+ * now dropped while waiting for the fw: instead of spinning for up
+ * to the cmd timeout with irqs off, we sleep on cmd_complete, which
+ * irq_work completes on HOST_INT_CMD_COMPLETE. The cmd_mutex keeps
+ * other cmds out of the mailbox meanwhile. The cmd status word, not
+ * the completion, decides the cmd is done, and it is still checked
+ * every jiffy, for when irq_work can't run (irqs off, or the cmd is
+ * issued from irq_work itself). The wait is bounded by the cmd timeout
+ * in jiffies.
  */
 
 int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
@@ -1501,10 +1781,11 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 {
 	unsigned long start = jiffies;
 	unsigned long timeout;
-	unsigned counter;
+	unsigned long waited;
 	const char *devname;
 	u16 irqtype;
 	u16 cmd_status = -1;
+	int done;
 	int rc;
 
 	acxmem_lock_flags;
@@ -1526,14 +1807,14 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 		goto bad;
 	}
 
-	if ((acx_debug & L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
+	if (acx_debug_enabled(L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
 		pr_acx("input buffer (len=%u):\n", buflen);
 		acx_dump_bytes(buffer, buflen);
 	}
 
 	/* wait for firmware to become idle for our command submission */
 	rc = acx_wait_cmd_status(adev, cmd, buffer, buflen,
-			cmd_timeout, cmdstr, devname);
+			cmd_timeout, cmdstr, devname, flags);
 	if (rc)
 		goto bad;
 
@@ -1558,7 +1839,13 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 	/* now write the actual command type */
 	acx_write_cmd_type_status(adev, cmd, 0);
 
+	/* forget a completion irq_work may have seen for an earlier cmd */
+	reinit_completion(&adev->cmd_complete);
+
 	/* execute command */
+	trace_acx_cmd_issue(adev, cmd,
+		buffer ? le16_to_cpu(((acx_ie_generic_t *) buffer)->type) : 0,
+		buflen);
 	write_reg16(adev, IO_ACX_INT_TRIG, INT_TRIG_CMD);
 	write_flush(adev);
 
@@ -1571,42 +1858,51 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 		cmd_timeout = 1199;
 
 	/* we schedule away sometimes (timeout can be large) */
-	counter = cmd_timeout;
-	/* pci only */
-	timeout = jiffies + cmd_timeout * HZ / 1000;
+	waited = jiffies;
+	timeout = waited + msecs_to_jiffies(cmd_timeout);
+	done = 0;
 
 	do {
 		irqtype = read_reg16(adev, IO_ACX_IRQ_STATUS_NON_DES);
-		if (irqtype & HOST_INT_CMD_COMPLETE) {
+		if (irqtype & HOST_INT_CMD_COMPLETE)
 			write_reg16(adev, IO_ACX_IRQ_ACK, HOST_INT_CMD_COMPLETE);
+
+		/* Only the status word tells it is our cmd that completed:
+		 * the completion may be a stale one irq_work signalled for
+		 * an earlier cmd, and irq_work's IO_ACX_IRQ_REASON read may
+		 * have consumed the irq bit of ours */
+		cmd_status = acx_read_cmd_type_status(adev);
+		if (cmd_status) {
+			done = 1;
 			break;
 		}
 
-		if (IS_MEM(adev))
-			udelay(1000);
-		else
-			msleep(1);
+		if (time_after_eq(jiffies, timeout))
+			break;
 
-	} while (likely(--counter));
+		/* Wakes early on cmd_complete; the one jiffy slice is for
+		 * when irq_work can't run */
+		acxmem_unlock();
+		wait_for_completion_timeout(&adev->cmd_complete, 1);
+		acxmem_lock();
+
+	} while (1);
 
-	/* save state for debugging */
-	cmd_status = acx_read_cmd_type_status(adev);
+	waited = jiffies_to_msecs(jiffies - waited);
+	trace_acx_cmd_done(adev, cmd, cmd_status, waited);
 
 	/* put the card in IDLE state */
 	acx_write_cmd_type_status(adev, ACX1xx_CMD_RESET, 0);
 
 	/* Timed out! */
-	if (counter == 0) { // pci == -1, trivial
+	if (!done) {
 
 		log(L_ANY, "%s: Timed out %s for CMD_COMPLETE. "
-			"irq bits:0x%02X timeout:%dms "
+			"irq bits:0x%02X timeout:%dms waited:%lums "
 			"cmd_status:%d (%s)\n", devname,
 		       (adev->irqs_active) ? "waiting" : "polling",
-		       irqtype, cmd_timeout,
+		       irqtype, cmd_timeout, waited,
 		       cmd_status, acx_cmd_status_str(cmd_status));
-		log(L_ANY,
-			"timeout: counter:%d cmd_timeout:%d cmd_timeout-counter:%d\n",
-			counter, cmd_timeout, cmd_timeout - counter);
 
 		if (IS_MEM(adev)) {
 			if (read_reg16(adev, IO_ACX_IRQ_MASK) == 0xffff) {
@@ -1615,11 +1911,10 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 			}
 		}
 	}
-	else if (cmd_timeout - counter > 30) { /* if waited >30ms... */
+	else if (waited > 30) { /* if waited >30ms... */
 		log(L_CTL|L_DEBUG,
-			"%s for CMD_COMPLETE %dms. count:%d. Please report\n",
-			(adev->irqs_active) ? "waited" : "polled",
-			cmd_timeout - counter, counter);
+			"%s for CMD_COMPLETE %lums. Please report\n",
+			(adev->irqs_active) ? "waited" : "polled", waited);
 	}
 
 	log(L_CTL, "%s: cmd=%s, buflen=%u, timeout=%ums, type=0x%04X: %s\n",
@@ -1647,7 +1942,7 @@ int _acx_issue_cmd_timeo_debug(acx_device_t *adev, unsigned cmd,
 		else
 			memcpy_fromio(buffer, adev->cmd_area + 4, buflen);
 
-		if (acx_debug & L_DEBUG) {
+		if (acx_debug_enabled(L_DEBUG)) {
 			log(L_ANY, "output buffer (len=%u): ", buflen);
 			acx_dump_bytes(buffer, buflen);
 		}
@@ -1988,13 +2283,19 @@ static void acxmem_i_set_multicast_list(struct net_device *ndev)
  * ==================================================
  */
 
-static void acx_process_rxdesc(acx_device_t *adev)
+/*
+ * acx_process_rxdesc
+ *
+ * Processes up to budget frames and returns the number done. If the
+ * budget was used up, more frames are likely waiting and irq_work has
+ * to poll again.
+ */
+static int acx_process_rxdesc(acx_device_t *adev, int budget)
 {
 	if(IS_PCI(adev))
-		acxpci_process_rxdesc(adev);
+		return acxpci_process_rxdesc(adev, budget);
 	else
-		acxmem_process_rxdesc(adev);
-
+		return acxmem_process_rxdesc(adev, budget);
 }
 
 /*
@@ -2013,7 +2314,7 @@ static txhostdesc_t *acx_get_txhostdesc(acx_device_t *adev, txacxdesc_t *txdesc,
 		return NULL;
 	}
 	index /= adev->hw_tx_queue[queue_id].acxdescinfo.size;
-	if (unlikely(ACX_DEBUG && (index >= TX_CNT))) {
+	if (unlikely(ACX_DEBUG && (index >= adev->tx_cnt))) {
 		pr_acx("bad txdesc ptr %p\n", txdesc);
 		return NULL;
 	}
@@ -2028,6 +2329,43 @@ void *_acx_get_txbuf(acx_device_t *adev, tx_t *tx_opaque, int q)
 	return acx_get_txhostdesc(adev, (txacxdesc_t *) tx_opaque, q)->data;
 }
 
+/*
+ * acx_tx_map_skb()
+ *
+ * Zero-copy tx (PCI): map the skb and point the hostdesc pair of the
+ * txdesc straight at it, split at BUF_LEN_HOSTDESC1 just like the
+ * copied-to txbuf would have been. Unmapped in acx_tx_clean_txdesc().
+ */
+int acx_tx_map_skb(acx_device_t *adev, tx_t *tx_opaque, struct sk_buff *skb,
+		int queue_id)
+{
+	txhostdesc_t *hostdesc1, *hostdesc2;
+	dma_addr_t phy;
+
+	hostdesc1 = acx_get_txhostdesc(adev, (txacxdesc_t *) tx_opaque, queue_id);
+	if (unlikely(!hostdesc1))
+		return -EINVAL;
+	hostdesc2 = hostdesc1 + 1;
+
+	phy = dma_map_single(adev->bus_dev, skb->data, skb->len, DMA_TO_DEVICE);
+	if (dma_mapping_error(adev->bus_dev, phy))
+		return -ENOMEM;
+
+	hostdesc1->data = skb->data;
+	hostdesc1->hd.data_phy = cpu2acx(phy);
+	/* a frame no longer than the header part (PS-Poll, ...) leaves
+	 * hostdesc2 empty, it must not point past the mapping */
+	if (skb->len > BUF_LEN_HOSTDESC1) {
+		hostdesc2->data = skb->data + BUF_LEN_HOSTDESC1;
+		hostdesc2->hd.data_phy = cpu2acx(phy + BUF_LEN_HOSTDESC1);
+	} else {
+		hostdesc2->data = NULL;
+		hostdesc2->hd.data_phy = 0;
+	}
+
+	return 0;
+}
+
 /*
  * acxmem_l_tx_data
  *
@@ -2038,6 +2376,10 @@ void *_acx_get_txbuf(acx_device_t *adev, tx_t *tx_opaque, int q)
  * FIXME: in case of fragments, should loop over the number of
  * pre-allocated tx descrs, properly setting up transfer data and
  * CTL_xxx flags according to fragment number.
+ *
+ * Called with acxmem_lock held, see acx_tx_queue_go(). The adapter
+ * is not told about the new descriptor here, acx_tx_kick() does that
+ * once for a whole batch.
  */
 #if 1	// pci version merge started
 void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
@@ -2053,10 +2395,6 @@ void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
 	u8 Ctl_8, Ctl2_8;
 	int wlhdr_len;
 	u32 addr;		// mem.c
-	acxmem_lock_flags;	// mem.c
-
-
-	acxmem_lock();
 
 	/* fw doesn't tx such packets anyhow */
 	/* if (unlikely(len < WLAN_HDR_A3_LEN))
@@ -2161,7 +2499,8 @@ void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
 		 * fragments */
 #endif
 
-		hostdesc1->hd.length = cpu_to_le16(wlhdr_len);
+		/* zero-copy maps just len bytes, see acx_tx_map_skb() */
+		hostdesc1->hd.length = cpu_to_le16(min(len, wlhdr_len));
 
 		if (IS_MEM(adev))
 		{
@@ -2204,7 +2543,6 @@ void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
 						| DESC_CTL_FIRSTFRAG);
 				adev->hw_tx_queue[queue_id].head = ((u8*) txdesc - (u8*) adev->hw_tx_queue[queue_id].acxdescinfo.start)
 						/ adev->hw_tx_queue[queue_id].acxdescinfo.size;
-				adev->hw_tx_queue[queue_id].free++;
 				goto end_of_chain;
 			}
 			/*
@@ -2240,17 +2578,15 @@ void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
 	}
 	/* unused: txdesc->tx_time = cpu_to_le32(jiffies); */
 
-	/*
-	 * Update the queue indicator to say there's data on the first queue.
-	 */
-	if (IS_MEM(adev))
-		acxmem_update_queue_indicator(adev, 0);
-
-	/* flush writes before we tell the adapter that it's its turn now */
-	write_reg16(adev, IO_ACX_INT_TRIG, INT_TRIG_TXPRC);
-	write_flush(adev);
-
 	hostdesc1->skb = skb;
+	hostdesc1->enqueued = skb->tstamp;
+	hostdesc1->submitted = ktime_get();
+	if (ktime_to_ns(hostdesc1->enqueued))
+		acx_tx_lat_add(adev, queue_id, ACX_TX_LAT_QUEUE,
+			hostdesc1->enqueued, hostdesc1->submitted);
+
+	/* hand it over to acx_tx_clean_txdesc() */
+	acx_tx_queued(adev, queue_id);
 
 	/* log the packet content AFTER sending it, in order to not
 	 * delay sending any further than absolutely needed Do
@@ -2260,7 +2596,7 @@ void _acx_tx_data(acx_device_t *adev, tx_t *tx_opaque, int len,
 end_of_chain:
 
 	/* Debugging */
-	if (unlikely(acx_debug & (L_XFER|L_DATA))) {
+	if (unlikely(acx_debug_enabled(L_XFER|L_DATA))) {
 		u16 fc = ((struct ieee80211_hdr *)
 			hostdesc1->data)->frame_control;
 		if (IS_ACX111(adev))
@@ -2281,17 +2617,32 @@ end_of_chain:
 				? "(SPr)" : "",
 				adev->status);
 
-		if (0 && acx_debug & L_DATA) {
+		if (0 && acx_debug_enabled(L_DATA)) {
 			pr_acx("tx: 802.11 [%d]: ", len);
 			acx_dump_bytes(hostdesc1->data, len);
 		}
 	}
+}
+#endif	// acxmem_tx_data()
 
-	acxmem_unlock();
-
+/*
+ * acx_tx_kick
+ *
+ * Tell the adapter that new txdescs are waiting, once per batch
+ * filled by _acx_tx_data(). Called with acxmem_lock held.
+ */
+void acx_tx_kick(acx_device_t *adev)
+{
+	/*
+	 * Update the queue indicator to say there's data on the first queue.
+	 */
+	if (IS_MEM(adev))
+		acxmem_update_queue_indicator(adev, 0);
 
+	/* flush writes before we tell the adapter that it's its turn now */
+	write_reg16(adev, IO_ACX_INT_TRIG, INT_TRIG_TXPRC);
+	write_flush(adev);
 }
-#endif	// acxmem_tx_data()
 
 /*
  * acxmem_l_clean_txdesc
@@ -2309,11 +2660,15 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 	txacxdesc_t *txdesc;
 	txhostdesc_t *hostdesc;
 	unsigned finger;
+	unsigned int pending;
 	int num_cleaned;
 	u16 r111;
 	u8 error, ack_failures, rts_failures, rts_ok, r100, Ctl_8;
 	u32 acxmem;
 	txacxdesc_t tmptxdesc;
+	/* mem: host copy of *txdesc, see below */
+	txacxdesc_t txd;
+	ktime_t now;
 
 	struct ieee80211_tx_info *txstatus;
 
@@ -2329,7 +2684,7 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 		tmptxdesc.Ctl_8 = DESC_CTL_HOSTOWN | DESC_CTL_FIRSTFRAG;
 		tmptxdesc.u.r1.rate = 0x0a;
 	}
-	if (unlikely(acx_debug & L_DEBUG))
+	if (unlikely(acx_debug_enabled(L_DEBUG)))
 		acx_log_txbuffer(adev, queue_id);
 
 	log(L_BUFT, "tx: cleaning up bufs from %u\n", adev->hw_tx_queue[queue_id].tail);
@@ -2342,8 +2697,9 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 	 * be freed also */
 
 	finger = adev->hw_tx_queue[queue_id].tail;
+	pending = acx_tx_pending(adev, queue_id);
 	num_cleaned = 0;
-	while (likely(finger != adev->hw_tx_queue[queue_id].head)) {
+	while (likely(num_cleaned < pending)) {
 		txdesc = acx_get_txacxdesc(adev, finger, queue_id);
 
 		/* If we allocated txdesc on tx path but then decided
@@ -2361,7 +2717,7 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 		if ((Ctl_8 & DESC_CTL_ACXDONE_HOSTOWN)
 			!= DESC_CTL_ACXDONE_HOSTOWN) {
 			/* maybe remove if wrapper */
-			if (unlikely(!num_cleaned) && (acx_debug & L_BUFT))
+			if (unlikely(!num_cleaned) && acx_debug_enabled(L_BUFT))
 				pr_warn("clean_txdesc: tail isn't free. "
 					"q=%d finger=%d, tail=%d, head=%d\n",
 				        queue_id, finger,
@@ -2372,17 +2728,19 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 
 		/* remember desc values... */
 		if (IS_MEM(adev)) {
-			error = read_slavemem8(adev, (uintptr_t) &(txdesc->error));
-			ack_failures = read_slavemem8(adev,
-					(uintptr_t) &(txdesc->ack_failures));
-			rts_failures = read_slavemem8(adev,
-					(uintptr_t) &(txdesc->rts_failures));
-			rts_ok = read_slavemem8(adev, (uintptr_t) &(txdesc->rts_ok));
+			/* mem: with Ctl_8 done, pull the desc over in one
+			 * burst instead of a slave memory access per
+			 * field; read ahead of Ctl_8 it may be stale.
+			 * Only the reset of the desc below goes back. */
+			acxmem_copy_from_slavemem(adev, (u8 *) &txd,
+						(uintptr_t) txdesc, sizeof(txd));
+			error = txd.error;
+			ack_failures = txd.ack_failures;
+			rts_failures = txd.rts_failures;
+			rts_ok = txd.rts_ok;
 			/* OW FIXME does this also require le16_to_cpu()? */
-			r100 = read_slavemem8(adev,
-					(uintptr_t) &(txdesc->u.r1.rate));
-			r111 = le16_to_cpu(read_slavemem16(adev,
-					(uintptr_t)&(txdesc->u.r2.rate111)));
+			r100 = txd.u.r1.rate;
+			r111 = le16_to_cpu(txd.u.r2.rate111);
 		} else {
 			error = txdesc->error;
 			ack_failures = txdesc->ack_failures;
@@ -2397,13 +2755,20 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 			"acx: tx: cleaned %u: !ACK=%u !RTS=%u RTS=%u"
 			" r100=%u r111=%04X tx_free=%u\n",
 			finger, ack_failures, rts_failures, rts_ok,
-			r100, r111, adev->hw_tx_queue[queue_id].free);
+			r100, r111, acx_tx_free(adev, queue_id));
 
 		/* need to check for certain error conditions before
 		 * we clean the descriptor: we still need valid descr
 		 * data here */
 		hostdesc = acx_get_txhostdesc(adev, txdesc, queue_id);
 
+		now = ktime_get();
+		acx_tx_lat_add(adev, queue_id, ACX_TX_LAT_HW,
+			hostdesc->submitted, now);
+		if (ktime_to_ns(hostdesc->enqueued))
+			acx_tx_lat_add(adev, queue_id, ACX_TX_LAT_TOTAL,
+				hostdesc->enqueued, now);
+
 		txstatus = IEEE80211_SKB_CB(hostdesc->skb);
 
 		if (!(txstatus->flags & IEEE80211_TX_CTL_NO_ACK)
@@ -2419,8 +2784,7 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 
 		/* Free up the transmit data buffers */
 		if (IS_MEM(adev)) {
-			acxmem = read_slavemem32(adev,
-						(uintptr_t) &(txdesc->AcxMemPtr));
+			acxmem = txd.AcxMemPtr.v;
 			if (acxmem)
 				acxmem_reclaim_acx_txbuf_space(adev, acxmem);
 
@@ -2432,6 +2796,9 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 				( sizeof(tmptxdesc)
 				  - sizeof(tmptxdesc.pNextDesc)));
 		} else {
+			if (adev->hw_tx_queue[queue_id].zerocopy)
+				acx_tx_unmap_skb(adev, hostdesc);
+
 			txdesc->error = 0;
 			txdesc->ack_failures = 0;
 			txdesc->rts_failures = 0;
@@ -2443,7 +2810,6 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 
 			txdesc->Ctl_8 = DESC_CTL_HOSTOWN;
 		}
-		adev->hw_tx_queue[queue_id].free++;
 		num_cleaned++;
 
 		/* do error checking, rate handling and logging
@@ -2453,10 +2819,16 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 					finger, txstatus);
 
 		/* And finally report upstream */
+		trace_acx_tx_status(adev, hostdesc->skb, queue_id, error,
+				ack_failures);
 
-		if (IS_MEM(adev))
+		if (acx_bench_tx_done(hostdesc->skb)) {
+			/* made up by bench.c, not for mac80211 */
+		} else if (IS_MEM(adev)) {
+			acx_tx_lat_clear(hostdesc->skb);
 			ieee80211_tx_status_irqsafe(adev->hw, hostdesc->skb);
-		else {
+		} else {
+			acx_tx_lat_clear(hostdesc->skb);
 #if CONFIG_ACX_MAC80211_VERSION < KERNEL_VERSION(2, 6, 37)
 			local_bh_disable();
 			ieee80211_tx_status(adev->hw, hostdesc->skb);
@@ -2465,11 +2837,15 @@ unsigned int acx_tx_clean_txdesc(acx_device_t *adev, int queue_id)
 			ieee80211_tx_status_ni(adev->hw, hostdesc->skb);
 #endif
 		}
+		hostdesc->skb = NULL;
+
 		/* update pointer for descr to be cleaned next */
-		finger = (finger + 1) % TX_CNT;
+		finger = (finger + 1) % adev->tx_cnt;
 	}
-	/* remember last position */
+	/* remember last position, and give the descs back to the tx
+	 * path */
 	adev->hw_tx_queue[queue_id].tail = finger;
+	acx_tx_cleaned(adev, queue_id, num_cleaned);
 
 
 	return num_cleaned;
@@ -2484,7 +2860,7 @@ void acx_clean_txdesc_emergency(acx_device_t *adev)
 
 
 
-	for (i = 0; i < TX_CNT; i++) {
+	for (i = 0; i < adev->tx_cnt; i++) {
 		txd = acx_get_txacxdesc(adev, i, 0);
 
 		/* free it */
@@ -2515,7 +2891,10 @@ void acx_clean_txdesc_emergency(acx_device_t *adev)
 #endif
 		write_slavemem32(adev, (uintptr_t) &(txd->AcxMemPtr), 0);
 	}
-	adev->hw_tx_queue[0].free = TX_CNT;
+	/* mem only, the tx path holds acxmem_lock: no one else is
+	 * touching the ring */
+	adev->hw_tx_queue[0].tail = adev->hw_tx_queue[0].head;
+	acx_tx_cleaned(adev, 0, acx_tx_pending(adev, 0));
 
 	if (IS_MEM(adev))
 		acxmem_init_acx_txbuf2(adev);
@@ -2653,10 +3032,10 @@ static int acx_is_hw_tx_queue_start_limit(acx_device_t *adev)
 
 	for (i=0; i<adev->num_hw_tx_queues; i++)
 	{
-		if (!(adev->hw_tx_queue[i].free >= TX_START_QUEUE))
+		if (!(acx_tx_free(adev, i) >= TX_START_QUEUE))
 		{
 			log(L_BUF, "Queue under start limie: queue_id=%d, free=%d\n",
-				i, adev->hw_tx_queue[i].free);
+				i, acx_tx_free(adev, i));
 			return 0;
 		}
 	}
@@ -2666,19 +3045,98 @@ static int acx_is_hw_tx_queue_start_limit(acx_device_t *adev)
 
 #define IRQ_ITERATE 0 // mem.c has it 1, but thats in #if0d code.
 
+/* Rate sampling window and timer period of the irq coalescing */
+#define ACX_IRQ_COALESCE_WINDOW	(HZ/10)
+#define ACX_IRQ_COALESCE_MIN_US	200
+#define ACX_IRQ_COALESCE_MAX_US	5000
+
+/*
+ * acx_irq_coalesce_update
+ *
+ * Accounts pkts tx-cleaned and rx'ed frames and, once per window,
+ * decides from the frame rate whether the per-frame tx/rx irqs stay
+ * masked. Above acx_irq_coalesce pkts/s they are masked and
+ * acx_coalesce_timer() cleans the rings from a timer instead; below
+ * half of it, we return to irq driven operation.
+ */
+static void acx_irq_coalesce_update(acx_device_t *adev, unsigned int pkts)
+{
+	unsigned long elapsed;
+	unsigned int pps;
+
+	if (!acx_irq_coalesce) {
+		adev->coalesce.active = 0;
+		return;
+	}
+
+	adev->coalesce.window_pkts += pkts;
+	elapsed = jiffies - adev->coalesce.window_start;
+	if (elapsed < ACX_IRQ_COALESCE_WINDOW)
+		return;
+
+	pps = adev->coalesce.window_pkts * HZ / elapsed;
+	adev->coalesce.last_pps = pps;
+	adev->coalesce.window_start = jiffies;
+	adev->coalesce.window_pkts = 0;
+
+	if (!adev->coalesce.active && pps >= acx_irq_coalesce) {
+		adev->coalesce.active = 1;
+		adev->coalesce.bursts++;
+		log(L_IRQ, "irq coalescing on: %u pkts/s\n", pps);
+	} else if (adev->coalesce.active && pps < acx_irq_coalesce / 2) {
+		adev->coalesce.active = 0;
+		log(L_IRQ, "irq coalescing off: %u pkts/s\n", pps);
+	}
+}
+
+/*
+ * Period of the coalesced clean: half the time the smaller of the rx
+ * and tx rings takes to fill at the last measured frame rate, so the
+ * rings are cleaned before they overrun.
+ */
+static unsigned int acx_irq_coalesce_period_us(acx_device_t *adev)
+{
+	unsigned int depth = min(adev->rx_cnt, adev->tx_cnt);
+	unsigned int pps = max(adev->coalesce.last_pps, 1u);
+
+	return clamp_t(unsigned int, depth * (USEC_PER_SEC / 2) / pps,
+		ACX_IRQ_COALESCE_MIN_US, ACX_IRQ_COALESCE_MAX_US);
+}
+
+/* Timer driven clean, while the tx/rx irqs are coalesced */
+enum hrtimer_restart acx_coalesce_timer(struct hrtimer *timer)
+{
+	acx_device_t *adev = container_of(timer, struct acx_device,
+					coalesce_timer);
+
+	if (!test_bit(ACX_FLAG_HW_UP, &adev->flags))
+		return HRTIMER_NORESTART;
+
+	adev->coalesce.timer_polls++;
+	ieee80211_queue_work(adev->hw, &adev->irq_work);
+
+	return HRTIMER_NORESTART;
+}
+
 /* Interrupt handler bottom-half */
 void acx_irq_work(struct work_struct *work)
 {
 	acx_device_t *adev = container_of(work, struct acx_device, irq_work);
 	int irqreason;
 	int irqmasked;
+	u16 rx_irq = IS_MEM(adev) ? HOST_INT_RX_DATA : HOST_INT_RX_COMPLETE;
+	u16 irq_mask;
+	int rx_budget = acx_rx_budget ? acx_rx_budget : adev->rx_cnt;
+	int rx_done;
+	unsigned int pkts = 0;
 	acxmem_lock_flags;
 	unsigned int irqcnt = 0; // but always do-while once, see IRQ_ITERATE
 	int i;
 
 
 
-	acx_sem_lock(adev);
+	/* No acx-sem here: tx cleanup and rx processing must not wait
+	 * for a cmd in progress. Only the after-irq jobs take it. */
 	acxmem_lock();
 
 	/* OW, 20100611: Iterating and latency:
@@ -2695,15 +3153,22 @@ void acx_irq_work(struct work_struct *work)
 	irqreason = read_reg16(adev, IO_ACX_IRQ_REASON);
 	irqmasked = irqreason & ~adev->irq_mask;
 	log(L_IRQ, "irqstatus=%04X, irqmasked==%04X\n", irqreason, irqmasked);
+	trace_acx_irq(adev, irqreason, irqmasked);
+
+	/* Coalescing: the rings are cleaned on every pass, whether
+	 * their irq reason was latched or not */
+	if (adev->coalesce.active)
+		irqmasked |= HOST_INT_TX_COMPLETE | rx_irq;
 
 #if IRQ_ITERATE
 	if (!irqmasked) break;
 #endif	/* IRQ_ITERATE */
 
 		/* HOST_INT_CMD_COMPLETE handling */
-		if (irqmasked & HOST_INT_CMD_COMPLETE) {
+		if (irqreason & HOST_INT_CMD_COMPLETE) {
 			log(L_IRQ, "got Command_Complete IRQ\n");
-			/* save the state for the running issue_cmd() */
+			/* wake up the waiting issue_cmd() */
+			complete(&adev->cmd_complete);
 		}
 
 		/* Tx reporting */
@@ -2738,10 +3203,16 @@ void acx_irq_work(struct work_struct *work)
 			 * resolved this problem.  Now WPA assoc
 			 * succeeds directly and robust.
 			 */
+			/* No tx_lock needed, the tx path may keep
+			 * filling the rings meanwhile, see
+			 * acx_tx_free() */
 			for (i=0; i<adev->num_hw_tx_queues; i++)
-				acx_tx_clean_txdesc(adev, i);
+				pkts += acx_tx_clean_txdesc(adev, i);
 
-			/* Restart queue if stopped and enough tx-descr free */
+			/* Restart queue if stopped and enough tx-descr
+			 * free. Pairs with the barrier in
+			 * acx_tx_stop_queue() in tx.c */
+			smp_mb();
 			if (acx_is_hw_tx_queue_start_limit(adev) &&
 				acx_queue_stopped(adev->hw))
 			{
@@ -2754,11 +3225,20 @@ void acx_irq_work(struct work_struct *work)
 		}
 
 		/* Rx processing TODO - examine merged flags !!! */
-		if (irqmasked
-			& (IS_MEM(adev)
-			   ? HOST_INT_RX_DATA : HOST_INT_RX_COMPLETE)) {
+		/* Budgeted, NAPI-like: if the budget is used up, the rx
+		 * irq stays masked and we come back for the rest in a
+		 * new pass, giving other work a chance in between. */
+		if ((irqmasked & rx_irq)
+			|| test_bit(ACX_FLAG_RX_POLLING, &adev->flags)) {
 			log(L_IRQ, "got Rx_Complete IRQ\n");
-			acx_process_rxdesc(adev);
+			acx_rx_lock(adev);
+			rx_done = acx_process_rxdesc(adev, rx_budget);
+			acx_rx_unlock(adev);
+			pkts += rx_done;
+			if (rx_done >= rx_budget)
+				set_bit(ACX_FLAG_RX_POLLING, &adev->flags);
+			else
+				clear_bit(ACX_FLAG_RX_POLLING, &adev->flags);
 		}
 #if IRQ_ITERATE
 		/* Tx new frames, after rx processing.  If queue is
@@ -2774,19 +3254,20 @@ void acx_irq_work(struct work_struct *work)
 
 		/* HOST_INT_SCAN_COMPLETE */
 		if (irqmasked & HOST_INT_SCAN_COMPLETE) {
-			if (test_bit(ACX_FLAG_SCANNING, &adev->flags)) {
+			/* test_and_clear: acx_stop() may abort the
+			 * scan meanwhile */
+			if (test_and_clear_bit(ACX_FLAG_SCANNING, &adev->flags)) {
 				struct cfg80211_scan_info info = {
 					.aborted = false
 				};
 				ieee80211_scan_completed(adev->hw, &info);
 				log(L_INIT, "scan completed\n");
-				clear_bit(ACX_FLAG_SCANNING, &adev->flags);
 			}
 		}
 
 		/* These we just log, but either they happen rarely
 		 * or we keep them masked out */
-		if (acx_debug & L_IRQ)
+		if (acx_debug_enabled(L_IRQ))
 			acx_log_irq(irqreason);
 
 	} while (irqcnt--);
@@ -2797,18 +3278,36 @@ void acx_irq_work(struct work_struct *work)
 	 * update_link_quality_led(adev);
 	 */
 
-	/* Renable irq-signal again for irqs we are interested in */
-	write_reg16(adev, IO_ACX_IRQ_MASK, adev->irq_mask);
+	acx_irq_coalesce_update(adev, pkts);
+
+	/* Renable irq-signal again for irqs we are interested in,
+	 * except rx while still polling and tx/rx while coalescing */
+	irq_mask = adev->irq_mask;
+	if (test_bit(ACX_FLAG_RX_POLLING, &adev->flags))
+		irq_mask |= rx_irq;
+	if (adev->coalesce.active)
+		irq_mask |= HOST_INT_TX_COMPLETE | rx_irq;
+	write_reg16(adev, IO_ACX_IRQ_MASK, irq_mask);
 	write_flush(adev);
 
 	acxmem_unlock();
 
+	if (test_bit(ACX_FLAG_RX_POLLING, &adev->flags)
+		&& test_bit(ACX_FLAG_HW_UP, &adev->flags))
+		ieee80211_queue_work(adev->hw, &adev->irq_work);
+	else if (adev->coalesce.active
+		&& test_bit(ACX_FLAG_HW_UP, &adev->flags))
+		hrtimer_start(&adev->coalesce_timer,
+			ns_to_ktime((u64) acx_irq_coalesce_period_us(adev)
+				* NSEC_PER_USEC), HRTIMER_MODE_REL);
+
 	/* after_interrupt_jobs: need to be done outside acx_lock
 	   (Sleeping required. None atomic) */
-	if (adev->after_interrupt_jobs)
+	if (adev->after_interrupt_jobs) {
+		acx_sem_lock(adev);
 		acx_after_interrupt_task(adev);
-
-	acx_sem_unlock(adev);
+		acx_sem_unlock(adev);
+	}
 
 
 	return;
@@ -2900,7 +3399,7 @@ void acx_handle_info_irq(acx_device_t *adev)
 
 void acx_set_interrupt_mask(acx_device_t *adev)
 {
-	if (acx_debug & L_DEBUG)
+	if (acx_debug_enabled(L_DEBUG))
 		interrupt_sanity_checks(adev);
 
 	pr_notice("adev->irq_mask: before: %d devtype:%d chiptype:%d tobe: %d\n",
@@ -2992,7 +3491,7 @@ static irqreturn_t acxmem_interrupt(int irq, void *dev_id)
 			 * acxmem_l_clean_txdesc() at a time when we
 			 * won't wakeup the net queue in there for
 			 * some reason...) */
-			if (adev->tx_free <= TX_START_CLEAN) {
+			if (adev->tx_free <= TX_START_CLEAN(adev)) {
 #if TX_CLEANUP_IN_SOFTIRQ
 				acx_schedule_task(adev,
 						ACX_AFTER_IRQ_TX_CLEANUP);
@@ -3146,10 +3645,9 @@ void acx_stop(acx_device_t *adev)
 
 	acxmem_lock_flags;
 
-	if (test_bit(ACX_FLAG_SCANNING, &adev->flags)) {
+	if (test_and_clear_bit(ACX_FLAG_SCANNING, &adev->flags)) {
 		ieee80211_scan_completed(adev->hw, &info);
 		acx_issue_cmd(adev, ACX1xx_CMD_STOP_SCAN, NULL, 0);
-		clear_bit(ACX_FLAG_SCANNING, &adev->flags);
 	}
 
 	acx_stop_queue(adev->hw, "on ifdown");
@@ -3163,9 +3661,14 @@ void acx_stop(acx_device_t *adev)
 	synchronize_irq(adev->irq);
 
 	acx_sem_unlock(adev);
+	hrtimer_cancel(&adev->coalesce_timer);
 	cancel_work_sync(&adev->irq_work);
+	/* irq_work may have re-armed it before seeing HW_UP cleared */
+	hrtimer_cancel(&adev->coalesce_timer);
 	cancel_work_sync(&adev->tx_work);
 	acx_sem_lock(adev);
+	clear_bit(ACX_FLAG_RX_POLLING, &adev->flags);
+	adev->coalesce.active = 0;
 
 	acx_tx_queue_flush(adev);
 
@@ -3262,7 +3765,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw, struct iw_request_info *info,
 	char fcserror[0x8];
 	char ratefallback[0x5];
 
-	if (!(acx_debug & (L_IOCTL | L_DEBUG)))
+	if (!acx_debug_enabled(L_IOCTL | L_DEBUG))
 		return OK;
 	/* using printk() since we checked debug flag already */
 
@@ -3417,7 +3920,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw, struct iw_request_info *info,
 
 	/* loop over complete receive pool */
 	if (rxdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump internal rxdesc %d:\n"
 				"mem pos %p\n"
 				"next 0x%X\n"
@@ -3441,7 +3944,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw, struct iw_request_info *info,
 
 		/* loop over complete receive pool */
 		if (rxhostdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump host rxdesc %d:\n"
 				"mem pos %p\n"
 				"buffer mem pos 0x%X\n"
@@ -3466,7 +3969,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw, struct iw_request_info *info,
 
 		/* loop over complete transmit pool */
 		if (txdesc)
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 			pr_acx("\ndump internal txdesc %d:\n"
 				"size 0x%X\n"
 				"mem pos %p\n"
@@ -3498,7 +4001,7 @@ int acx111pci_ioctl_info(struct ieee80211_hw *hw, struct iw_request_info *info,
 
 		/* loop over complete host send pool */
 		if (txhostdesc)
-		for (i = 0; i < TX_CNT * 2; i++) {
+		for (i = 0; i < adev->tx_cnt * 2; i++) {
 			pr_acx("\ndump host txdesc %d:\n"
 				"mem pos %p\n"
 				"buffer mem pos 0x%X\n"
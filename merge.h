@@ -41,6 +41,10 @@ DECL_OR_STUB ( PCI_OR_MEM,
 	void acx_irq_disable(acx_device_t *adev),
 	{ } )
 
+DECL_OR_STUB ( PCI_OR_MEM,
+	int acx_read_eeprom(acx_device_t *adev),
+	{ return 0; } )
+
 DECL_OR_STUB ( PCI_OR_MEM,
 	int acx_read_eeprom_byte(acx_device_t *adev, u32 addr, u8 *charbuf),
 	{ return 0; } )
@@ -49,6 +53,10 @@ DECL_OR_STUB ( PCI_OR_MEM,
 	char *acx_proc_eeprom_output(int *length, acx_device_t *adev),
 	{ return (char*) NULL; } )
 
+DECL_OR_STUB ( PCI_OR_MEM,
+	void acx_process_rxdesc_skb(acx_device_t *adev, rxhostdesc_t *hostdesc),
+	{ } )
+
 DECL_OR_STUB ( PCI_OR_MEM,
 	void acx_set_interrupt_mask(acx_device_t *adev),
 	{ } )
@@ -83,18 +91,26 @@ DECL_OR_STUB ( PCI_OR_MEM,
 			struct ieee80211_tx_info *info, struct sk_buff *skb, int queue_id),
 	{ } )
 
+DECL_OR_STUB ( PCI_OR_MEM,
+	void acx_tx_kick(acx_device_t *adev),
+	{ } )
+
 DECL_OR_STUB ( PCI_OR_MEM,
 	void acx_irq_work(struct work_struct *work),
 	{ } )
 
+DECL_OR_STUB ( PCI_OR_MEM,
+	enum hrtimer_restart acx_coalesce_timer(struct hrtimer *timer),
+	{ return HRTIMER_NORESTART; } )
+
 DECL_OR_STUB ( PCI_OR_MEM,
 	int acx_write_fw(acx_device_t *adev, const firmware_image_t *fw_image,
-			u32 offset),
+			u32 offset, int burst),
 	{ return 0; } )
 
 DECL_OR_STUB ( PCI_OR_MEM,
 	int acx_validate_fw(acx_device_t *adev,
-			const firmware_image_t *fw_image, u32 offset),
+			const firmware_image_t *fw_image, u32 offset, int full),
 	{ return 0; } )
 
 DECL_OR_STUB ( PCI_OR_MEM,
@@ -142,6 +158,11 @@ DECL_OR_STUB ( PCI_OR_MEM,
 	void *_acx_get_txbuf(acx_device_t * adev, tx_t * tx_opaque, int queue_id),
 	{ return (void*) NULL; } )
 
+DECL_OR_STUB ( PCI_OR_MEM,
+	int acx_tx_map_skb(acx_device_t *adev, tx_t *tx_opaque,
+			struct sk_buff *skb, int queue_id),
+	{ return -ENODEV; } )
+
 
 #if (defined CONFIG_ACX_MAC80211_PCI || defined CONFIG_ACX_MAC80211_MEM)
 
@@ -177,7 +177,7 @@ acxpci_issue_cmd_timeo_debug(acx_device_t * adev, unsigned cmd,
 		goto bad;
 	}
 
-	if ((acx_debug & L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
+	if (acx_debug_enabled(L_DEBUG) && (cmd != ACX1xx_CMD_INTERROGATE)) {
 		pr_acx("input buffer (len=%u):\n", buflen);
 		acx_dump_bytes(buffer, buflen);
 	}
@@ -314,7 +314,7 @@ acxpci_issue_cmd_timeo_debug(acx_device_t * adev, unsigned cmd,
 	if (buffer && buflen && (cmd == ACX1xx_CMD_INTERROGATE)) {
 		/* adev->cmd_area points to PCI device's memory, not to RAM! */
 		memcpy_fromio(buffer, adev->cmd_area + 4, buflen);
-		if (acx_debug & L_DEBUG) {
+		if (acx_debug_enabled(L_DEBUG)) {
 			pr_acx("output buffer (len=%u): ", buflen);
 			acx_dump_bytes(buffer, buflen);
 		}
@@ -405,7 +405,7 @@ int acxpci_dbgfs_diag_output(struct seq_file *file, acx_device_t *adev)
 	seq_printf(file, "** Rx buf **\n");
 	rxhostdesc = adev->hw_rx_queue.hostdescinfo.start;
 	if (rxhostdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			rtl = (i == adev->hw_rx_queue.tail) ? " [tail]" : "";
 			if ((rxhostdesc->hd.Ctl_16 & cpu_to_le16(DESC_CTL_HOSTOWN))
 			    && (rxhostdesc->hd.Status & cpu_to_le32(DESC_STATUS_FULL)))
@@ -418,12 +418,12 @@ int acxpci_dbgfs_diag_output(struct seq_file *file, acx_device_t *adev)
 	for(queue_id=0; queue_id<adev->num_hw_tx_queues; queue_id++){
 
 		seq_printf(file, "** Tx buf (q=%d, free %d, Ieee80211 queue: %s) **\n",
-			queue_id, adev->hw_tx_queue[queue_id].free,
+			queue_id, acx_tx_free(adev, queue_id),
 			acx_queue_stopped(adev->hw) ? "STOPPED" : "running");
 
 		txdesc = adev->hw_tx_queue[queue_id].acxdescinfo.start;
 		if (txdesc)
-			for (i = 0; i < TX_CNT; i++) {
+			for (i = 0; i < adev->tx_cnt; i++) {
 				thd = (i == adev->hw_tx_queue[queue_id].head) ? " [head]" : "";
 				ttl = (i == adev->hw_tx_queue[queue_id].tail) ? " [tail]" : "";
 
@@ -492,7 +492,7 @@ tx_t* acxpci_alloc_tx(acx_device_t * adev, int queue_id)
 
 
 
-	if (unlikely(!adev->hw_tx_queue[queue_id].free)) {
+	if (unlikely(!acx_tx_free(adev, queue_id))) {
 		pr_acx("BUG: no free txdesc left\n");
 		txdesc = NULL;
 		goto end;
@@ -518,17 +518,34 @@ tx_t* acxpci_alloc_tx(acx_device_t * adev, int queue_id)
 	/* Needed in case txdesc won't be eventually submitted for tx */
 	txdesc->Ctl_8 = DESC_CTL_ACXDONE_HOSTOWN;
 
-	adev->hw_tx_queue[queue_id].free--;
-	log(L_BUFT, "tx: got desc %u, %u remain\n", head, adev->hw_tx_queue[queue_id].free);
+	log(L_BUFT, "tx: got desc %u, %u remain\n", head,
+		acx_tx_free(adev, queue_id) - 1);
 
 	/* returning current descriptor, so advance to next free one */
-	adev->hw_tx_queue[queue_id].head = (head + 1) % TX_CNT;
+	adev->hw_tx_queue[queue_id].head = (head + 1) % adev->tx_cnt;
 end:
 
 
 	return (tx_t *) txdesc;
 }
 
+/*
+ * acxpci_dealloc_tx
+ *
+ * Gives back the txdesc just taken by acxpci_alloc_tx(), for when it
+ * won't be submitted after all.
+ */
+void acxpci_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque, int queue_id)
+{
+	struct txacxdesc *txdesc = (struct txacxdesc *) tx_opaque;
+
+	txdesc->Ctl_8 = DESC_CTL_HOSTOWN;
+
+	adev->hw_tx_queue[queue_id].head =
+		(adev->hw_tx_queue[queue_id].head + adev->tx_cnt - 1) % adev->tx_cnt;
+	log(L_BUFT, "tx: returned desc %u\n", adev->hw_tx_queue[queue_id].head);
+}
+
 int acxpci_load_firmware(acx_device_t *adev)
 {
 	char fw_combined_filename[PCI_FIRMWARE_FILENAME_MAXLEN];
@@ -564,12 +581,17 @@ int acxpci_load_firmware(acx_device_t *adev)
 	return rc;
 }
 
-void acxpci_process_rxdesc(acx_device_t *adev)
+/*
+ * Processes at most budget filled rx descriptors and returns how many
+ * were handled.
+ */
+int acxpci_process_rxdesc(acx_device_t *adev, int budget)
 {
 	register rxhostdesc_t *hostdesc;
 	unsigned count, tail;
+	int done = 0;
 
-	if (unlikely(acx_debug & L_BUFR))
+	if (unlikely(acx_debug_enabled(L_BUFR)))
 		acx_log_rxbuffer(adev);
 
 	/* First, have a loop to determine the first descriptor that's
@@ -577,12 +599,12 @@ void acxpci_process_rxdesc(acx_device_t *adev)
 	 * rx_tail and the full descriptor we're supposed to
 	 * handle. */
 	tail = adev->hw_rx_queue.tail;
-	count = RX_CNT;
+	count = adev->rx_cnt;
 	while (1) {
 		hostdesc = &adev->hw_rx_queue.hostdescinfo.start[tail];
 
 		/* advance tail regardless of outcome of the below test */
-		tail = (tail + 1) % RX_CNT;
+		tail = (tail + 1) % adev->rx_cnt;
 
 		if ((hostdesc->hd.Ctl_16 & cpu_to_le16(DESC_CTL_HOSTOWN))
 		        && (hostdesc->hd.Status & cpu_to_le32(DESC_STATUS_FULL)))
@@ -598,7 +620,10 @@ void acxpci_process_rxdesc(acx_device_t *adev)
 		log(L_BUF,
 		        "rx: tail=%u Ctl_16=%04X Status=%08X\n", tail, hostdesc->hd.Ctl_16, hostdesc->hd.Status);
 
-		acx_process_rxbuf(adev, hostdesc->data);
+		if (adev->hw_rx_queue.zerocopy)
+			acx_process_rxdesc_skb(adev, hostdesc);
+		else
+			acx_process_rxbuf(adev, hostdesc->data);
 		hostdesc->hd.Status = 0;
 
 		/* flush all writes before adapter sees CTL_HOSTOWN change */
@@ -607,6 +632,9 @@ void acxpci_process_rxdesc(acx_device_t *adev)
 		/* Host no longer owns this, needs to be LAST */
 		CLEAR_BIT(hostdesc->hd.Ctl_16, cpu_to_le16(DESC_CTL_HOSTOWN));
 
+		if (++done >= budget)
+			break;
+
 		/* ok, descriptor is handled, now check the next descriptor */
 		hostdesc = &adev->hw_rx_queue.hostdescinfo.start[tail];
 
@@ -615,11 +643,12 @@ void acxpci_process_rxdesc(acx_device_t *adev)
 		        || !(hostdesc->hd.Status & cpu_to_le32(DESC_STATUS_FULL)))
 			break;
 
-		tail = (tail + 1) % RX_CNT;
+		tail = (tail + 1) % adev->rx_cnt;
 	}
 
 	end:
 	adev->hw_rx_queue.tail = tail;
+	return done;
 }
 
 
@@ -721,7 +750,7 @@ int acx111pci_ioctl_info(struct net_device *ndev,
 	char fcserror[0x8];
 	char ratefallback[0x5];
 
-	if (!(acx_debug & (L_IOCTL | L_DEBUG)))
+	if (!acx_debug_enabled(L_IOCTL | L_DEBUG))
 		return OK;
 	/* using printk() since we checked debug flag already */
 
@@ -862,7 +891,7 @@ int acx111pci_ioctl_info(struct net_device *ndev,
 
 	/* loop over complete receive pool */
 	if (rxdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump internal rxdesc %d:\n"
 			       "mem pos %p\n"
 			       "next 0x%X\n"
@@ -886,7 +915,7 @@ int acx111pci_ioctl_info(struct net_device *ndev,
 
 	/* loop over complete receive pool */
 	if (rxhostdesc)
-		for (i = 0; i < RX_CNT; i++) {
+		for (i = 0; i < adev->rx_cnt; i++) {
 			pr_acx("\ndump host rxdesc %d:\n"
 			       "mem pos %p\n"
 			       "buffer mem pos 0x%X\n"
@@ -911,7 +940,7 @@ int acx111pci_ioctl_info(struct net_device *ndev,
 
 	/* loop over complete transmit pool */
 	if (txdesc)
-		for (i = 0; i < TX_CNT; i++) {
+		for (i = 0; i < adev->tx_cnt; i++) {
 			pr_acx("\ndump internal txdesc %d:\n"
 			       "size 0x%X\n"
 			       "mem pos %p\n"
@@ -942,7 +971,7 @@ int acx111pci_ioctl_info(struct net_device *ndev,
 
 	/* loop over complete host send pool */
 	if (txhostdesc)
-		for (i = 0; i < TX_CNT * 2; i++) {
+		for (i = 0; i < adev->tx_cnt * 2; i++) {
 			pr_acx("\ndump host txdesc %d:\n"
 			       "mem pos %p\n"
 			       "buffer mem pos 0x%X\n"
@@ -1039,6 +1068,67 @@ int acx100pci_ioctl_set_phy_amp_bias(struct net_device *ndev,
  * id	- ptr to the device id entry that matched this device
  */
 #ifdef CONFIG_PCI
+/* The slow part of acxpci_probe(), see acx_probe_async() */
+static int acxpci_probe_finish(acx_device_t *adev)
+{
+	struct ieee80211_hw *hw = adev->hw;
+	int err = -EIO;
+
+	/* Load firmware */
+	acx_get_hardware_info(adev);
+
+	if (acxpci_load_firmware(adev))
+		goto fail_load_firmware;
+
+	if (acx_reset_on_probe(adev))
+		goto fail_reset_on_probe;
+
+	/* From the EEPROM copy made by acx_reset_on_probe() */
+#ifdef NONESSENTIAL_FEATURES
+	acx_show_card_eeprom_id(adev);
+#endif /* NONESSENTIAL_FEATURES */
+
+	/* Debugfs */
+	if (acx_debugfs_add_adev(adev))
+		goto fail_debugfs;
+
+	/* need to be able to restore PCI state after a suspend */
+#ifdef CONFIG_PM
+	pci_save_state(adev->pdev);
+#endif
+
+	/* Init ieee80211_hw  */
+	acx_init_ieee80211(adev, hw);
+	hw->wiphy->interface_modes =
+			BIT(NL80211_IFTYPE_STATION) |
+			BIT(NL80211_IFTYPE_ADHOC) |
+			BIT(NL80211_IFTYPE_AP);
+
+	if ((err=ieee80211_register_hw(hw))) {
+		pr_acx("ieee80211_register_hw() FAILED: %d\n", err);
+		goto fail_ieee80211_register_hw;
+	}
+
+#if CMD_DISCOVERY
+	great_inquisitor(adev);
+#endif
+
+	return OK;
+
+	/* error paths: undo everything in reverse order... */
+	fail_ieee80211_register_hw:
+	acx_debugfs_remove_adev(adev);
+
+	fail_debugfs:
+
+	fail_reset_on_probe:
+
+	fail_load_firmware:
+	acx_free_firmware(adev);
+
+	return err;
+}
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 8, 0)
 static int __devinit acxpci_probe(struct pci_dev *pdev,
 #else
@@ -1188,60 +1278,14 @@ static int acxpci_probe(struct pci_dev *pdev,
 	/* Acx irqs shall be off and are enabled later in acx_up */
 	acx_irq_disable(adev);
 
-#ifdef NONESSENTIAL_FEATURES
-	acx_show_card_eeprom_id(adev);
-#endif /* NONESSENTIAL_FEATURES */
-
-
-	/* PCI setup is finished, now start initializing the card */
-
-	/* Load firmware */
-	acx_get_hardware_info(adev);
-
-	if (acxpci_load_firmware(adev))
-		goto fail_load_firmware;
-
-	if (acx_reset_on_probe(adev))
-		goto fail_reset_on_probe;
-
-	/* Debugfs */
-	if (acx_debugfs_add_adev(adev))
-		goto fail_debugfs;
-
-	/* need to be able to restore PCI state after a suspend */
-#ifdef CONFIG_PM
-	pci_save_state(pdev);
-#endif
-
-	/* Init ieee80211_hw  */
-	acx_init_ieee80211(adev, hw);
-	hw->wiphy->interface_modes =
-			BIT(NL80211_IFTYPE_STATION) |
-			BIT(NL80211_IFTYPE_ADHOC) |
-			BIT(NL80211_IFTYPE_AP);
-
-	if ((err=ieee80211_register_hw(hw))) {
-		pr_acx("ieee80211_register_hw() FAILED: %d\n", err);
-		goto fail_ieee80211_register_hw;
-	}
-
-#if CMD_DISCOVERY
-	great_inquisitor(adev);
-#endif
+	/* PCI setup is finished, initializing the card is left to
+	 * acxpci_probe_finish() */
+	acx_probe_async(adev, acxpci_probe_finish);
 
 	result = OK;
 	goto done;
 
 	/* error paths: undo everything in reverse order... */
-	fail_ieee80211_register_hw:
-	ieee80211_unregister_hw(hw);
-
-	fail_debugfs:
-
-	fail_reset_on_probe:
-
-	fail_load_firmware:
-	acx_free_firmware(adev);
 
 	/* request_irq(adev->irq, acxpci_i_interrupt, IRQF_SHARED, KBUILD_MODNAME, */
 	fail_request_irq:
@@ -1314,9 +1358,11 @@ static void acxpci_remove(struct pci_dev *pdev)
 		return;
 	}
 
-	/* Unregister ieee80211 device */
+	/* Unregister ieee80211 device, if acxpci_probe_finish() got
+	 * that far */
 	log(L_INIT, "removing device %s\n", wiphy_name(adev->hw->wiphy));
-	ieee80211_unregister_hw(adev->hw);
+	if (!acx_probe_wait(adev))
+		ieee80211_unregister_hw(adev->hw);
 
 	/* If device wasn't hot unplugged... */
 	if (acxpci_adev_present(adev)) {
@@ -1422,6 +1468,10 @@ static int acxpci_e_suspend(struct pci_dev *pdev, pm_message_t state)
 	adev = hw2adev(hw);
 	pr_acx("sus: adev %p\n", adev);
 
+	/* never came up, see acx_probe_async() */
+	if (acx_probe_wait(adev))
+		return OK;
+
 	acx_sem_lock(adev);
 
 	ieee80211_unregister_hw(hw);	/* this one cannot sleep */
@@ -1452,6 +1502,9 @@ static int acxpci_e_resume(struct pci_dev *pdev)
 	adev = hw2adev(hw);
 	pr_acx("rsm: got adev %p\n", adev);
 
+	if (acx_probe_wait(adev))
+		return OK;
+
 	acx_sem_lock(adev);
 
 	pci_set_power_state(pdev, PCI_D0);
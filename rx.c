@@ -25,6 +25,7 @@
 #include "usb.h"
 #include "utils.h"
 #include "rx.h"
+#include "trace.h"
 
 /*
  * Calculate level like the feb 2003 windows driver seems to do
@@ -109,34 +110,48 @@ const char* acx_get_packet_type_string(u16 fc)
  *
  * The end of the Rx path. Pulls data from a rxhostdesc into a socket
  * buffer and feeds it to the network stack via netif_rx().
+ *
+ * If skb is given, rxbuf lives in its data area (zero-copy rx): the
+ * skb is trimmed down to the 802.11 frame instead of copying it.
  */
-static void acx_rx(acx_device_t *adev, rxbuffer_t *rxbuf)
+static void acx_rx(acx_device_t *adev, rxbuffer_t *rxbuf,
+		struct sk_buff *skb)
 {
 	struct ieee80211_rx_status *status;
 
 	struct ieee80211_hdr *w_hdr;
-	struct sk_buff *skb;
 	int buflen;
+	int hdr_ofs;
 	int level;
 
 	if (unlikely(!test_bit(ACX_FLAG_HW_UP, &adev->flags))) {
 		pr_info("asked to receive a packet while hw down\n");
-		return;
+		goto drop;
 	}
 
 	w_hdr = acx_get_wlan_hdr(adev, rxbuf);
 	buflen = RXBUF_BYTES_RCVD(adev, rxbuf);
 
-	/* Allocate our skb */
-	skb = dev_alloc_skb(buflen);
-	if (!skb) {
-		pr_info("skb allocation FAILED\n");
-		return;
+	if (skb) {
+		hdr_ofs = (u8*) w_hdr - skb->data;
+		if (unlikely(hdr_ofs + buflen > skb_tailroom(skb))) {
+			pr_info("rx frame too long: %d\n", buflen);
+			goto drop;
+		}
+		skb_reserve(skb, hdr_ofs);
+		skb_put(skb, buflen);
+	} else {
+		/* Allocate our skb */
+		skb = dev_alloc_skb(buflen);
+		if (!skb) {
+			pr_info("skb allocation FAILED\n");
+			return;
+		}
+
+		skb_put(skb, buflen);
+		memcpy(skb->data, w_hdr, buflen);
 	}
 
-	skb_put(skb, buflen);
-	memcpy(skb->data, w_hdr, buflen);
-
 	status = IEEE80211_SKB_RXCB(skb);
 	memset(status, 0, sizeof(*status));
 
@@ -171,6 +186,10 @@ static void acx_rx(acx_device_t *adev, rxbuffer_t *rxbuf)
 			acx_plcp_get_bitrate_cck(rxbuf->phy_plcp_signal);
 #endif
 
+	trace_acx_rx(adev, skb, status->signal);
+	adev->stats.rx_packets++;
+	adev->stats.rx_bytes += skb->len;
+
 	if (IS_PCI(adev)) {
 #if CONFIG_ACX_MAC80211_VERSION <= KERNEL_VERSION(2, 6, 32)
 		local_bh_disable();
@@ -183,12 +202,16 @@ static void acx_rx(acx_device_t *adev, rxbuffer_t *rxbuf)
 	/* Usb Rx is happening in_interupt() */
 	else if (IS_USB(adev) || IS_MEM(adev))
 		ieee80211_rx_irqsafe(adev->hw, skb);
-	else
+	else {
 		logf0(L_ANY, "ERROR: Undefined device type !?\n");
+		goto drop;
+	}
 
-	adev->stats.rx_packets++;
-	adev->stats.rx_bytes += skb->len;
+	return;
 
+drop:
+	if (skb)
+		dev_kfree_skb_any(skb);
 }
 
 /*
@@ -196,7 +219,8 @@ static void acx_rx(acx_device_t *adev, rxbuffer_t *rxbuf)
  *
  * NB: used by USB code also
  */
-void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf)
+static void _acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf,
+			struct sk_buff *skb)
 {
 	struct ieee80211_hdr *hdr;
 	u16 fc, buf_len;
@@ -210,7 +234,7 @@ void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf)
 
 	/* For debugging */
 	if (((IEEE80211_FCTL_STYPE & fc) != IEEE80211_STYPE_BEACON)
-		&& (acx_debug & (L_XFER|L_DATA))) {
+		&& acx_debug_enabled(L_XFER|L_DATA)) {
 
 		printk_ratelimited(
 			"acx: rx: %s time:%u len:%u signal:%u,raw=%u"
@@ -227,18 +251,19 @@ void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf)
 			adev->status);
 	}
 
-	if (unlikely(acx_debug & L_DATA)) {
+	if (unlikely(acx_debug_enabled(L_DATA))) {
 		pr_info("rx: 802.11 buf[%u]: \n", buf_len);
 		acx_dump_bytes(hdr, buf_len);
 	}
 
-	acx_rx(adev, rxbuf);
-
-	/* Now check Rx quality level, AFTER processing packet.  I
-	 * tried to figure out how to map these levels to dBm values,
-	 * but for the life of me I really didn't manage to get
-	 * it. Either these values are not meant to be expressed in
-	 * dBm, or it's some pretty complicated calculation. */
+	/* Now check Rx quality level.  I tried to figure out how to
+	 * map these levels to dBm values, but for the life of me I
+	 * really didn't manage to get it. Either these values are not
+	 * meant to be expressed in dBm, or it's some pretty
+	 * complicated calculation.
+	 *
+	 * This is done before acx_rx(): with zero-copy rx, rxbuf
+	 * belongs to the skb handed up the stack. */
 
 	/* FIXME OW 20100619 Is this still required. Only for adev local use.
 	 * Mac80211 signal level is reported in acx_l_rx for each skb.
@@ -246,7 +271,21 @@ void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf)
 	/* TODO: only the RSSI seems to be reported */
 	adev->rx_status.signal = acx_signal_to_winlevel(rxbuf->phy_level);
 
+	acx_rx(adev, rxbuf, skb);
+}
 
+void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf)
+{
+	_acx_process_rxbuf(adev, rxbuf, NULL);
+}
+
+/*
+ * Zero-copy variant: skb->data holds the rxbuffer_t, ownership of the
+ * skb passes to us.
+ */
+void acx_process_rxskb(acx_device_t *adev, struct sk_buff *skb)
+{
+	_acx_process_rxbuf(adev, (rxbuffer_t*) skb->data, skb);
 }
 
 /* TODO Verify these functions: translation rxbuffer.phy_plcp_signal to rate_idx */
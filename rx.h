@@ -2,6 +2,7 @@
 #define _ACX_RX_H_
 
 void acx_process_rxbuf(acx_device_t *adev, rxbuffer_t *rxbuf);
+void acx_process_rxskb(acx_device_t *adev, struct sk_buff *skb);
 u8 acx_signal_determine_quality(u8 signal, u8 noise);
 
 #if !ACX_DEBUG
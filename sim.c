@@ -0,0 +1,1196 @@
+/*
+ * Copyright (C) 2003, 2004, 2005, 2006, 2007, 2008
+ * The ACX100 Open Source Project <acx100-devel@lists.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Simulated acx111 device
+ *
+ * A software model of an acx111 PCI card, to run the driver's
+ * tx/rx/cmd paths on machines without the hardware (load tests,
+ * benchmarks).
+ *
+ * The device poses as DEVTYPE_PCI, so all of merge.c runs unchanged.
+ * Only the register accesses in inlines.h are diverted here, see
+ * IS_SIM(). The two memory windows, iobase (registers) and iobase2
+ * (cmd/info mailbox and the acx-side descriptor rings), are plain
+ * RAM. The host-side rx hostdescs and buffers are reached through the
+ * driver's own CPU pointers to them, not over their bus addresses, so
+ * the model works behind an iommu too.
+ *
+ * A kthread per device plays the eCPU: it executes mailbox cmds,
+ * completes submitted txdescs, injects rx frames at a configured
+ * rate and raises the resulting irqs by calling acx_interrupt().
+ *
+ * The model is just good enough for the driver: no radio, no air,
+ * every tx succeeds at the first try.
+ */
+
+#include "acx_debug.h"
+
+#define pr_acx	pr_info
+
+#include <linux/version.h>
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/sched.h>
+#include <linux/types.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/kthread.h>
+#include <linux/wait.h>
+#include <linux/ktime.h>
+#include <linux/platform_device.h>
+#include <linux/dma-mapping.h>
+#include <linux/interrupt.h>
+#include <net/mac80211.h>
+
+#include <asm/io.h>
+
+#include "acx.h"
+#include "merge.h"
+#include "debug.h"
+#include "cmd.h"
+#include "ie.h"
+#include "main.h"
+#include "boot.h"
+#include "pci.h"
+#include "sim.h"
+#include "inlines.h"
+
+/*
+ * BOM Config
+ * ==================================================
+ */
+
+#define ACXSIM_MAX_DEVS		8
+
+#define ACXSIM_IOBASE_SIZE	0x2000
+#define ACXSIM_IOBASE2_SIZE	0x20000
+
+/* iobase2 layout */
+#define ACXSIM_CMD_MBOX		0x1000
+#define ACXSIM_INFO_MBOX	0x2000
+#define ACXSIM_MBOX_SIZE	0x1000
+#define ACXSIM_QUEUES		0x3000
+
+#define ACXSIM_SLAVEMEM_SIZE	0x20000
+#define ACXSIM_EEPROM_SIZE	0x400
+#define ACXSIM_PHY_SIZE		0x100
+/* size of the dummy image "uploaded" to slave memory */
+#define ACXSIM_FW_SIZE		0x4000
+
+#define ACXSIM_RADIO		RADIO_16_RADIA_RC2422
+#define ACXSIM_FW_ID		"Rev 2.3.1.31"
+#define ACXSIM_HW_ID		0x03010101	/* TNETW1130 */
+/* fw >= 2.0 always includes the phy header on acx111, see
+ * acx_update_rx_config() */
+#define ACXSIM_PHY_HDR_LEN	8
+
+/* rx injection tick while rx is enabled */
+#define ACXSIM_RX_TICK_NS	(100 * NSEC_PER_USEC)
+#define ACXSIM_RX_LEN_MIN	(WLAN_HDR_A3_LEN + 8)
+#define ACXSIM_RX_LEN_MAX	WLAN_A3FR_MAXLEN
+
+/* CONFIGUREd IEs are kept for later INTERROGATEs */
+#define ACXSIM_IE_SLOTS		0x80
+#define ACXSIM_IE_MAX		0x40
+
+/* acx_cmd_status_str() */
+#define ACXSIM_CMD_SUCCESS	1
+#define ACXSIM_CMD_INVALID	14
+
+#define ACXSIM_TXDESC_SIZE	(sizeof(txacxdesc_t) + 4)
+
+#define ACXSIM_CMD(c)		(acx_cmd_descs[c].val)
+#define ACXSIM_IE(i)		(acx_ie_descs[i].val)
+
+enum {
+	ACXSIM_FW_RUNNING,
+	ACXSIM_RX_ENABLED,
+	ACXSIM_CMD_PENDING,
+	ACXSIM_KICK,
+};
+
+struct acxsim {
+	acx_device_t *adev;
+	struct platform_device *pdev;
+
+	/* lock: registers and irq status
+	 * fw_lock: eCPU state; held by the fw thread for a whole pass,
+	 *	so halting the eCPU waits for the pass to finish
+	 * irq_lock: irq delivery, see acxsim_irq()
+	 * Order: fw_lock, lock */
+	spinlock_t lock;
+	spinlock_t fw_lock;
+	spinlock_t irq_lock;
+
+	u32 reg[IO_ACX_ECPU_CTRL + 1];
+	u16 irq_status;
+
+	u8 *iobase;
+	u8 *iobase2;
+	u32 *slavemem;
+	u32 slv_addr;
+	u32 fw_len;
+
+	u8 eeprom[ACXSIM_EEPROM_SIZE];
+	u8 phy[ACXSIM_PHY_SIZE];
+	u8 mac[ETH_ALEN];
+	u8 bssid[ETH_ALEN];
+
+	u8 ie[ACXSIM_IE_SLOTS][ACXSIM_IE_MAX];
+	u8 ie_len[ACXSIM_IE_SLOTS];
+
+	/* queues, as laid out by MEMORY_CONFIG_OPTIONS */
+	unsigned int tx_queues;
+	unsigned int tx_cnt[ACX111_NUM_HW_TX_QUEUES];
+	u32 tx_queue[ACX111_NUM_HW_TX_QUEUES];
+	unsigned int rx_cnt;
+	u32 rx_queue;
+	u32 queues_end;
+	dma_addr_t host_rx_start;
+	unsigned int rx_head;
+
+	ktime_t rx_last;
+	u64 rx_credit;
+	u8 rxframe[ACXSIM_RX_LEN_MAX];
+	unsigned int rxframe_len;
+
+	struct task_struct *thread;
+	wait_queue_head_t wq;
+	unsigned long flags;
+
+	struct {
+		u64 cmds;
+		u64 irqs;
+		u64 tx;
+		u64 tx_bytes;
+		u64 rx;
+		u64 rx_dropped;
+	} stats;
+};
+
+/*
+ * BOM Helpers
+ * ==================================================
+ */
+
+static inline u8 *acxsim_cmd_mbox(struct acxsim *sim)
+{
+	return sim->iobase2 + ACXSIM_CMD_MBOX;
+}
+
+static void acxsim_kick(struct acxsim *sim)
+{
+	set_bit(ACXSIM_KICK, &sim->flags);
+	wake_up(&sim->wq);
+}
+
+static void acxsim_raise(struct acxsim *sim, u16 irqs)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&sim->lock, flags);
+	sim->irq_status |= irqs;
+	spin_unlock_irqrestore(&sim->lock, flags);
+}
+
+/*
+ * Deliver pending unmasked irqs. acx_interrupt() is called from the fw
+ * thread, never from within a register access, since the handler
+ * itself writes IO_ACX_IRQ_MASK.
+ */
+static void acxsim_irq(struct acxsim *sim)
+{
+	unsigned long flags;
+	u16 pending;
+
+	spin_lock_irqsave(&sim->irq_lock, flags);
+	pending = READ_ONCE(sim->irq_status)
+		& ~READ_ONCE(sim->reg[IO_ACX_IRQ_MASK]);
+	if ((READ_ONCE(sim->reg[IO_ACX_FEMR]) & 0x8000) && pending) {
+		sim->stats.irqs++;
+		acx_interrupt(0, sim->adev);
+	}
+	spin_unlock_irqrestore(&sim->irq_lock, flags);
+}
+
+static int acxsim_ie_slot(u16 type)
+{
+	if (type & ~0x103f)
+		return -1;
+	return (type & 0x3f) | ((type & 0x1000) ? 0x40 : 0);
+}
+
+static void acxsim_ie_store(struct acxsim *sim, u16 type, const u8 *data,
+			unsigned int len)
+{
+	int slot = acxsim_ie_slot(type);
+
+	if (slot < 0)
+		return;
+	len = min_t(unsigned int, len, ACXSIM_IE_MAX);
+	memcpy(sim->ie[slot], data, len);
+	sim->ie_len[slot] = len;
+}
+
+/* fw reboot: forget the config, the station id comes from EEPROM */
+static void acxsim_ie_reset(struct acxsim *sim)
+{
+	u8 id[ETH_ALEN];
+	int i;
+
+	memset(sim->ie_len, 0, sizeof(sim->ie_len));
+
+	for (i = 0; i < ETH_ALEN; i++)
+		id[i] = sim->mac[ETH_ALEN - 1 - i];
+	acxsim_ie_store(sim, ACXSIM_IE(ACX1xx_IE_DOT11_STATION_ID),
+			id, ETH_ALEN);
+}
+
+/*
+ * BOM Registers
+ * ==================================================
+ */
+
+/* Called with fw_lock and lock held */
+static void acxsim_boot(struct acxsim *sim)
+{
+	if (!sim->fw_len) {
+		pr_acx("acxsim: eCPU started without firmware\n");
+		return;
+	}
+
+	memset(sim->iobase2 + ACXSIM_CMD_MBOX, 0, ACXSIM_MBOX_SIZE);
+	memset(sim->iobase2 + ACXSIM_INFO_MBOX, 0, ACXSIM_MBOX_SIZE);
+	sim->reg[IO_ACX_CMD_MAILBOX_OFFS] = ACXSIM_CMD_MBOX;
+	sim->reg[IO_ACX_INFO_MAILBOX_OFFS] = ACXSIM_INFO_MBOX;
+
+	sim->tx_queues = 0;
+	sim->rx_cnt = 0;
+	sim->queues_end = ACXSIM_QUEUES;
+	acxsim_ie_reset(sim);
+
+	set_bit(ACXSIM_FW_RUNNING, &sim->flags);
+	/* what acx_verify_init() waits for */
+	sim->irq_status |= HOST_INT_FCS_THRESHOLD;
+}
+
+/* Called with fw_lock and lock held */
+static void acxsim_halt(struct acxsim *sim)
+{
+	clear_bit(ACXSIM_FW_RUNNING, &sim->flags);
+	clear_bit(ACXSIM_RX_ENABLED, &sim->flags);
+	clear_bit(ACXSIM_CMD_PENDING, &sim->flags);
+}
+
+/*
+ * Writes that change the eCPU state. fw_lock makes them wait for a fw
+ * pass in progress: once e.g. IO_ACX_ENABLE is cleared in
+ * acx_delete_dma_regions(), no more rx is written to host memory.
+ */
+static void acxsim_write_ctl(struct acxsim *sim, unsigned int offset,
+			u32 val)
+{
+	unsigned long flags;
+	u32 old;
+
+	spin_lock(&sim->fw_lock);
+	spin_lock_irqsave(&sim->lock, flags);
+
+	old = sim->reg[offset];
+	sim->reg[offset] = val;
+
+	switch (offset) {
+	case IO_ACX_SOFT_RESET:
+		if (!(val & 1))
+			break;
+		acxsim_halt(sim);
+		sim->irq_status = 0;
+		sim->reg[IO_ACX_IRQ_MASK] = HOST_INT_MASK_ALL;
+		sim->reg[IO_ACX_FEMR] = 0;
+		sim->reg[IO_ACX_EEPROM_INFORMATION] = 0;
+		break;
+	case IO_ACX_ECPU_CTRL:
+		if (val & 1)
+			acxsim_halt(sim);
+		else if (old & 1)
+			acxsim_boot(sim);
+		break;
+	case IO_ACX_ENABLE:
+		if (!val)
+			clear_bit(ACXSIM_RX_ENABLED, &sim->flags);
+		break;
+	}
+
+	spin_unlock_irqrestore(&sim->lock, flags);
+	spin_unlock(&sim->fw_lock);
+}
+
+u32 acxsim_read_reg(acx_device_t *adev, unsigned int offset)
+{
+	struct acxsim *sim = adev->sim;
+	unsigned long flags;
+	u32 val;
+
+	if (offset > IO_ACX_ECPU_CTRL)
+		return 0;
+
+	spin_lock_irqsave(&sim->lock, flags);
+	switch (offset) {
+	case IO_ACX_SLV_MEM_DATA:
+		val = (sim->slv_addr < ACXSIM_SLAVEMEM_SIZE)
+			? sim->slavemem[sim->slv_addr / 4] : 0;
+		if (sim->reg[IO_ACX_SLV_MEM_CTL] & 1)
+			sim->slv_addr += 4;
+		break;
+	case IO_ACX_IRQ_STATUS_NON_DES:
+		val = sim->irq_status;
+		break;
+	case IO_ACX_IRQ_REASON:
+		/* cleared on read */
+		val = sim->irq_status;
+		sim->irq_status = 0;
+		break;
+	default:
+		val = sim->reg[offset];
+		break;
+	}
+	spin_unlock_irqrestore(&sim->lock, flags);
+
+	return val;
+}
+
+void acxsim_write_reg(acx_device_t *adev, unsigned int offset, u32 val)
+{
+	struct acxsim *sim = adev->sim;
+	unsigned long flags;
+	int kick = 0;
+	u32 addr;
+
+	if (offset > IO_ACX_ECPU_CTRL)
+		return;
+
+	switch (offset) {
+	case IO_ACX_SOFT_RESET:
+	case IO_ACX_ECPU_CTRL:
+	case IO_ACX_ENABLE:
+		acxsim_write_ctl(sim, offset, val);
+		return;
+	}
+
+	spin_lock_irqsave(&sim->lock, flags);
+	switch (offset) {
+	case IO_ACX_SLV_MEM_ADDR:
+		sim->slv_addr = val & ~3;
+		break;
+	case IO_ACX_SLV_MEM_DATA:
+		if (sim->slv_addr < ACXSIM_SLAVEMEM_SIZE) {
+			sim->slavemem[sim->slv_addr / 4] = val;
+			sim->fw_len = max(sim->fw_len, sim->slv_addr + 4);
+		}
+		if (sim->reg[IO_ACX_SLV_MEM_CTL] & 1)
+			sim->slv_addr += 4;
+		break;
+	case IO_ACX_EE_START:
+		/* radio type shows up once the EEPROM burst read is done */
+		if (val & 1)
+			sim->reg[IO_ACX_EEPROM_INFORMATION] =
+				ACXSIM_RADIO << 8;
+		break;
+	case IO_ACX_EEPROM_CTL:
+		addr = sim->reg[IO_ACX_EEPROM_ADDR] % ACXSIM_EEPROM_SIZE;
+		if (val & 2)
+			sim->reg[IO_ACX_EEPROM_DATA] = sim->eeprom[addr];
+		else if (val & 1)
+			sim->eeprom[addr] = sim->reg[IO_ACX_EEPROM_DATA];
+		val = 0;
+		break;
+	case IO_ACX_PHY_CTL:
+		addr = sim->reg[IO_ACX_PHY_ADDR] % ACXSIM_PHY_SIZE;
+		if (val & 2)
+			sim->reg[IO_ACX_PHY_DATA] = sim->phy[addr];
+		else if (val & 1)
+			sim->phy[addr] = sim->reg[IO_ACX_PHY_DATA];
+		val = 0;
+		break;
+	case IO_ACX_INT_TRIG:
+		if (val & INT_TRIG_CMD)
+			set_bit(ACXSIM_CMD_PENDING, &sim->flags);
+		kick = 1;
+		val = 0;
+		break;
+	case IO_ACX_IRQ_ACK:
+		sim->irq_status &= ~val;
+		break;
+	case IO_ACX_IRQ_MASK:
+	case IO_ACX_FEMR:
+		/* may unmask an irq latched meanwhile */
+		kick = 1;
+		break;
+	}
+	sim->reg[offset] = val;
+	spin_unlock_irqrestore(&sim->lock, flags);
+
+	if (kick)
+		acxsim_kick(sim);
+
+	/* like synchronize_irq(): no acx_interrupt() after disabling */
+	if (offset == IO_ACX_FEMR && !(val & 0x8000)) {
+		spin_lock_irqsave(&sim->irq_lock, flags);
+		spin_unlock_irqrestore(&sim->irq_lock, flags);
+	}
+}
+
+/*
+ * BOM Firmware
+ * ==================================================
+ */
+
+/* The ACX111 config options, see acx_parse_configoption() */
+static unsigned int acxsim_configoption(u8 *p)
+{
+	static const u8 rates[] = { 0x02, 0x04, 0x0b, 0x16, 0x0c, 0x12,
+				    0x18, 0x24, 0x30, 0x48, 0x60, 0x6c };
+	static const u8 domains[] = { 0x10, 0x20, 0x30, 0x31, 0x32, 0x40 };
+	static const char product[] = "acx111 sim";
+	static const char manuf[] = "ACX100 Open Source Project";
+	u8 *start = p;
+
+	memcpy(p, "SIMNVS01", 8);		/* NVSv */
+	p += 8;
+	*(__le16 *) p = cpu_to_le16(0);		/* NVS_vendor_offs */
+	p += 2;
+	*(__le16 *) p = cpu_to_le16(1);		/* unknown */
+	p += 2;
+	*(__le32 *) p = cpu_to_le32(ACXSIM_SLAVEMEM_SIZE); /* eof_memory */
+	p += 4;
+	*p++ = 0x01;	/* dot11CCAModes */
+	*p++ = 0x01;	/* dot11Diversity */
+	*p++ = 0x01;	/* dot11ShortPreambleOption */
+	*p++ = 0x01;	/* dot11PBCCOption */
+	*p++ = 0x00;	/* dot11ChannelAgility */
+	*p++ = 0x05;	/* dot11PhyType */
+	*p++ = 0x01;	/* dot11TempType */
+	*p++ = 6;	/* table_count */
+
+	*p++ = 0x01;	/* antennas */
+	*p++ = 2;
+	*p++ = 0x01;
+	*p++ = 0x02;
+
+	*p++ = 0x02;	/* power levels, u16 each */
+	*p++ = 2;
+	*(__le16 *) p = cpu_to_le16(0x0001);
+	p += 2;
+	*(__le16 *) p = cpu_to_le16(0x0002);
+	p += 2;
+
+	*p++ = 0x03;	/* data rates */
+	*p++ = sizeof(rates);
+	memcpy(p, rates, sizeof(rates));
+	p += sizeof(rates);
+
+	*p++ = 0x04;	/* regulatory domains, the first is the default */
+	*p++ = sizeof(domains);
+	memcpy(p, domains, sizeof(domains));
+	p += sizeof(domains);
+
+	*p++ = 0x05;	/* product id */
+	*p++ = sizeof(product) - 1;
+	memcpy(p, product, sizeof(product) - 1);
+	p += sizeof(product) - 1;
+
+	*p++ = 0x06;	/* manufacturer */
+	*p++ = sizeof(manuf) - 1;
+	memcpy(p, manuf, sizeof(manuf) - 1);
+	p += sizeof(manuf) - 1;
+
+	return p - start;
+}
+
+/*
+ * Lay out the acx-side rings in iobase2. The rx ring comes pre-linked
+ * and pointing to the host rx descs, as on the real acx111, see
+ * acx_create_rx_desc_queue().
+ */
+static int acxsim_memory_config(struct acxsim *sim,
+				const acx111_ie_memoryconfig_t *mc)
+{
+	txacxdesc_t *txdesc;
+	rxacxdesc_t *rxdesc;
+	u32 offs = ACXSIM_QUEUES;
+	unsigned int q, i, n;
+
+	n = min_t(unsigned int, mc->count_tx_queues, ACX111_NUM_HW_TX_QUEUES);
+	for (i = 0; i < n; i++) {
+		sim->tx_queue[i] = offs;
+		sim->tx_cnt[i] = mc->tx_queue[i].count_descs;
+		offs += sim->tx_cnt[i] * ACXSIM_TXDESC_SIZE;
+	}
+	sim->rx_queue = offs;
+	sim->rx_cnt = mc->rx_queue1_count_descs;
+	offs += sim->rx_cnt * sizeof(rxacxdesc_t);
+
+	if (offs > ACXSIM_IOBASE2_SIZE || !sim->rx_cnt) {
+		pr_acx("acxsim: memory config doesn't fit: %u rx descs, "
+			"queues end at 0x%X\n", sim->rx_cnt, offs);
+		sim->tx_queues = 0;
+		sim->rx_cnt = 0;
+		return -EINVAL;
+	}
+	sim->tx_queues = n;
+	sim->queues_end = offs;
+	sim->host_rx_start = acx2cpu(mc->rx_queue1_host_rx_start);
+	sim->rx_head = 0;
+
+	memset(sim->iobase2 + ACXSIM_QUEUES, 0, offs - ACXSIM_QUEUES);
+
+	/* free descs are host owned, acx_create_tx_desc_queue() relies
+	 * on this, and the tx pass must not take them for submitted */
+	for (q = 0; q < n; q++) {
+		for (i = 0; i < sim->tx_cnt[q]; i++) {
+			txdesc = (txacxdesc_t *) (sim->iobase2
+				+ sim->tx_queue[q] + i * ACXSIM_TXDESC_SIZE);
+			txdesc->Ctl_8 = DESC_CTL_HOSTOWN;
+		}
+	}
+
+	rxdesc = (rxacxdesc_t *) (sim->iobase2 + sim->rx_queue);
+	for (i = 0; i < sim->rx_cnt; i++, rxdesc++) {
+		rxdesc->pNextDesc = cpu2acx(sim->rx_queue
+			+ ((i + 1) % sim->rx_cnt) * sizeof(rxacxdesc_t));
+		rxdesc->HostMemPtr = cpu2acx(sim->host_rx_start
+			+ i * sizeof(rxhostdesc_t));
+	}
+
+	return 0;
+}
+
+static void acxsim_interrogate(struct acxsim *sim, u16 type, u8 *ie,
+			unsigned int len)
+{
+	u8 *data = ie + 4;
+	int slot = acxsim_ie_slot(type);
+	unsigned int i;
+
+	memset(data, 0, len);
+	if (slot >= 0 && sim->ie_len[slot])
+		memcpy(data, sim->ie[slot], min_t(unsigned int, len,
+						sim->ie_len[slot]));
+
+	if (type == ACXSIM_IE(ACX111_IE_CONFIG_OPTIONS)) {
+		acxsim_configoption(data);
+	} else if (type == ACXSIM_IE(ACX1xx_IE_FWREV)) {
+		fw_ver_t *fw = (fw_ver_t *) ie;
+
+		strncpy(fw->fw_id, ACXSIM_FW_ID, FW_ID_SIZE);
+		fw->hw_id = cpu_to_le32(ACXSIM_HW_ID);
+	} else if (type == ACXSIM_IE(ACX111_IE_QUEUE_CONFIG)) {
+		acx111_ie_queueconfig_t *qc = (acx111_ie_queueconfig_t *) ie;
+
+		qc->tx_memory_block_address = cpu_to_le32(sim->queues_end);
+		qc->rx_memory_block_address = cpu_to_le32(sim->queues_end);
+		qc->rx1_queue_address = cpu_to_le32(sim->rx_queue);
+		for (i = 0; i < sim->tx_queues; i++)
+			qc->tx_queue[i].address = cpu_to_le32(sim->tx_queue[i]);
+	} else if (type == ACXSIM_IE(ACX1xx_IE_MEMORY_MAP)) {
+		acx_ie_memmap_t *mm = (acx_ie_memmap_t *) ie;
+
+		mm->CodeStart = cpu_to_le32(0);
+		mm->CodeEnd = cpu_to_le32(sim->fw_len);
+		mm->QueueStart = cpu_to_le32(ACXSIM_QUEUES);
+		mm->QueueEnd = cpu_to_le32(sim->queues_end);
+		mm->PoolStart = cpu_to_le32(sim->queues_end);
+		mm->PoolEnd = cpu_to_le32(ACXSIM_IOBASE2_SIZE);
+	}
+}
+
+static void acxsim_do_cmd(struct acxsim *sim)
+{
+	u8 *mbox = acxsim_cmd_mbox(sim);
+	u8 *ie = mbox + 4;
+	u16 cmd = le32_to_cpu(*(__le32 *) mbox) & 0xffff;
+	u16 type = le16_to_cpu(*(__le16 *) ie);
+	unsigned int len = le16_to_cpu(*(__le16 *) (ie + 2));
+	u16 status = ACXSIM_CMD_SUCCESS;
+	u16 irqs = HOST_INT_CMD_COMPLETE;
+
+	len = min_t(unsigned int, len, ACXSIM_MBOX_SIZE - 8);
+	sim->stats.cmds++;
+
+	if (cmd == ACXSIM_CMD(ACX1xx_CMD_INTERROGATE)) {
+		acxsim_interrogate(sim, type, ie, len);
+	} else if (cmd == ACXSIM_CMD(ACX1xx_CMD_CONFIGURE)) {
+		if (type == ACXSIM_IE(ACX111_IE_MEMORY_CONFIG_OPTIONS)
+			&& acxsim_memory_config(sim,
+				(acx111_ie_memoryconfig_t *) ie))
+			status = ACXSIM_CMD_INVALID;
+		else
+			acxsim_ie_store(sim, type, ie + 4, len);
+	} else if (cmd == ACXSIM_CMD(ACX1xx_CMD_ENABLE_RX)) {
+		sim->rx_last = ktime_get();
+		sim->rx_credit = 0;
+		if (sim->rx_cnt)
+			set_bit(ACXSIM_RX_ENABLED, &sim->flags);
+	} else if (cmd == ACXSIM_CMD(ACX1xx_CMD_DISABLE_RX)) {
+		clear_bit(ACXSIM_RX_ENABLED, &sim->flags);
+	} else if (cmd == ACXSIM_CMD(ACX1xx_CMD_SCAN)) {
+		/* nothing out there */
+		irqs |= HOST_INT_SCAN_COMPLETE;
+	}
+
+	/* results before status */
+	wmb();
+	*(__le32 *) mbox = cpu_to_le32(cmd | (status << 16));
+
+	acxsim_raise(sim, irqs);
+}
+
+/* Complete every submitted txdesc, see acx_tx_clean_txdesc() */
+static void acxsim_do_tx(struct acxsim *sim)
+{
+	txacxdesc_t *txdesc;
+	unsigned int q, i, done = 0;
+
+	for (q = 0; q < sim->tx_queues; q++) {
+		for (i = 0; i < sim->tx_cnt[q]; i++) {
+			txdesc = (txacxdesc_t *) (sim->iobase2 + sim->tx_queue[q]
+				+ i * ACXSIM_TXDESC_SIZE);
+
+			if (READ_ONCE(txdesc->Ctl_8) & DESC_CTL_ACXDONE_HOSTOWN)
+				continue;
+			/* desc contents after ownership */
+			rmb();
+
+			sim->stats.tx_bytes += le16_to_cpu(txdesc->total_length);
+			txdesc->error = 0;
+			txdesc->ack_failures = 0;
+			txdesc->rts_failures = 0;
+			txdesc->rts_ok = 0;
+
+			wmb();
+			txdesc->Ctl_8 |= DESC_CTL_ACXDONE_HOSTOWN;
+			done++;
+		}
+	}
+
+	if (done) {
+		sim->stats.tx += done;
+		acxsim_raise(sim, HOST_INT_TX_COMPLETE);
+	}
+}
+
+/* A broadcast data frame from a sim AP, LLC/SNAP IPv4, zero payload */
+static void acxsim_build_rxframe(struct acxsim *sim, unsigned int len)
+{
+	static const u8 snap[] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00,
+				   0x08, 0x00 };
+	struct ieee80211_hdr *hdr = (struct ieee80211_hdr *) sim->rxframe;
+
+	memset(sim->rxframe, 0, len);
+	hdr->frame_control = cpu_to_le16(IEEE80211_FTYPE_DATA
+		| IEEE80211_STYPE_DATA | IEEE80211_FCTL_FROMDS);
+	memset(hdr->addr1, 0xff, ETH_ALEN);
+	memcpy(hdr->addr2, sim->bssid, ETH_ALEN);
+	memcpy(hdr->addr3, sim->bssid, ETH_ALEN);
+	memcpy(sim->rxframe + WLAN_HDR_A3_LEN, snap, sizeof(snap));
+
+	sim->rxframe_len = len;
+}
+
+/*
+ * Inject rx frames at acx_sim_rx_pps into the host rx ring, like the
+ * busmaster does: fill the buffer, mark it full, then hand the desc
+ * over. A desc still owned by the host means the ring is full, and
+ * the frame is lost.
+ */
+static void acxsim_do_rx(struct acxsim *sim)
+{
+	rxhostdesc_t *hostdescs = sim->adev->hw_rx_queue.hostdescinfo.start;
+	rxhostdesc_t *hostdesc;
+	rxbuffer_t *rxbuf;
+	ktime_t now = ktime_get();
+	u64 elapsed;
+	unsigned int pps = READ_ONCE(acx_sim_rx_pps);
+	unsigned int len = clamp_t(unsigned int, READ_ONCE(acx_sim_rx_len),
+				ACXSIM_RX_LEN_MIN, ACXSIM_RX_LEN_MAX);
+	unsigned int n, done = 0;
+
+	if (!hostdescs)
+		return;
+
+	elapsed = min_t(u64, ktime_to_ns(ktime_sub(now, sim->rx_last)),
+			NSEC_PER_SEC);
+	sim->rx_last = now;
+	sim->rx_credit += elapsed * pps;
+	n = div_u64(sim->rx_credit, NSEC_PER_SEC);
+	sim->rx_credit -= (u64) n * NSEC_PER_SEC;
+	if (!n)
+		return;
+
+	if (len != sim->rxframe_len)
+		acxsim_build_rxframe(sim, len);
+
+	while (n--) {
+		hostdesc = &hostdescs[sim->rx_head];
+
+		if (READ_ONCE(hostdesc->hd.Ctl_16)
+			& cpu_to_le16(DESC_CTL_HOSTOWN)) {
+			sim->stats.rx_dropped += n + 1;
+			break;
+		}
+
+		rxbuf = hostdesc->data;
+		memset(rxbuf, 0, offsetof(rxbuffer_t, hdr_a3));
+		rxbuf->mac_cnt_rcvd = cpu_to_le16(len + ACXSIM_PHY_HDR_LEN);
+		rxbuf->mac_status = 0x21;	/* BDCST, FCSGD */
+		rxbuf->phy_level = 60;
+		rxbuf->phy_snr = 40;
+		rxbuf->time = cpu_to_le32((u32) ktime_to_us(now));
+		memset(&rxbuf->hdr_a3, 0, ACXSIM_PHY_HDR_LEN);
+		memcpy((u8 *) &rxbuf->hdr_a3 + ACXSIM_PHY_HDR_LEN,
+			sim->rxframe, len);
+
+		hostdesc->hd.Status = cpu_to_le32(DESC_STATUS_FULL);
+		/* frame and status before ownership */
+		wmb();
+		SET_BIT(hostdesc->hd.Ctl_16, cpu_to_le16(DESC_CTL_HOSTOWN));
+
+		sim->rx_head = (sim->rx_head + 1) % sim->rx_cnt;
+		done++;
+	}
+
+	if (done) {
+		sim->stats.rx += done;
+		acxsim_raise(sim, HOST_INT_RX_COMPLETE);
+	}
+}
+
+/* The eCPU */
+static int acxsim_fw_thread(void *arg)
+{
+	struct acxsim *sim = arg;
+
+	while (!kthread_should_stop()) {
+		if (!test_bit(ACXSIM_RX_ENABLED, &sim->flags))
+			wait_event_interruptible(sim->wq,
+				test_bit(ACXSIM_KICK, &sim->flags)
+				|| kthread_should_stop());
+		else if (READ_ONCE(acx_sim_rx_pps))
+			wait_event_interruptible_hrtimeout(sim->wq,
+				test_bit(ACXSIM_KICK, &sim->flags)
+				|| kthread_should_stop(),
+				ns_to_ktime(ACXSIM_RX_TICK_NS));
+		else
+			/* look at simrxpps now and then */
+			wait_event_interruptible_timeout(sim->wq,
+				test_bit(ACXSIM_KICK, &sim->flags)
+				|| kthread_should_stop(), HZ / 10);
+		clear_bit(ACXSIM_KICK, &sim->flags);
+
+		spin_lock(&sim->fw_lock);
+		if (test_bit(ACXSIM_FW_RUNNING, &sim->flags)) {
+			if (test_and_clear_bit(ACXSIM_CMD_PENDING, &sim->flags))
+				acxsim_do_cmd(sim);
+			acxsim_do_tx(sim);
+			if (test_bit(ACXSIM_RX_ENABLED, &sim->flags))
+				acxsim_do_rx(sim);
+		}
+		spin_unlock(&sim->fw_lock);
+
+		acxsim_irq(sim);
+	}
+
+	return 0;
+}
+
+/* A dummy image with a valid checksum, see acx_validate_fw() */
+static firmware_image_t *acxsim_fw_image(void)
+{
+	firmware_image_t *fw_image;
+	u32 sum = 0;
+	u8 *p;
+	int i;
+
+	fw_image = vmalloc(offsetof(firmware_image_t, data) + ACXSIM_FW_SIZE);
+	if (!fw_image)
+		return NULL;
+
+	fw_image->size = cpu_to_le32(ACXSIM_FW_SIZE);
+	p = (u8 *) &fw_image->size;
+	for (i = 0; i < 4; i++)
+		sum += p[i];
+
+	p = fw_image->data;
+	for (i = 0; i < ACXSIM_FW_SIZE; i++) {
+		p[i] = (u8) (i * 7 + 0x5a);
+		sum += p[i];
+	}
+	fw_image->chksum = cpu_to_le32(sum);
+
+	return fw_image;
+}
+
+static struct acxsim *acxsim_alloc(struct platform_device *pdev)
+{
+	struct acxsim *sim;
+
+	sim = vzalloc(sizeof(*sim));
+	if (!sim)
+		return NULL;
+
+	sim->iobase = vzalloc(ACXSIM_IOBASE_SIZE);
+	sim->iobase2 = vzalloc(ACXSIM_IOBASE2_SIZE);
+	sim->slavemem = vzalloc(ACXSIM_SLAVEMEM_SIZE);
+	if (!sim->iobase || !sim->iobase2 || !sim->slavemem)
+		goto fail;
+
+	sim->pdev = pdev;
+	spin_lock_init(&sim->lock);
+	spin_lock_init(&sim->fw_lock);
+	spin_lock_init(&sim->irq_lock);
+	init_waitqueue_head(&sim->wq);
+
+	/* locally administered */
+	sim->mac[0] = 0x02;
+	sim->mac[2] = 0xac;
+	sim->mac[3] = 0x51;
+	sim->mac[5] = pdev->id;
+	memcpy(sim->bssid, sim->mac, ETH_ALEN);
+	sim->bssid[4] = 0xff;
+
+	sim->eeprom[0x05] = 5;	/* eeprom_version, see acx_reset_on_probe() */
+
+	sim->reg[IO_ACX_ECPU_CTRL] = 1;	/* halted */
+	sim->reg[IO_ACX_IRQ_MASK] = HOST_INT_MASK_ALL;
+
+	return sim;
+
+fail:
+	vfree(sim->slavemem);
+	vfree(sim->iobase2);
+	vfree(sim->iobase);
+	vfree(sim);
+	return NULL;
+}
+
+static void acxsim_free(struct acxsim *sim)
+{
+	vfree(sim->slavemem);
+	vfree(sim->iobase2);
+	vfree(sim->iobase);
+	vfree(sim);
+}
+
+/*
+ * BOM Mac80211 Ops
+ * ==================================================
+ */
+
+static const struct ieee80211_ops acxsim_hw_ops = {
+	.tx		= acx_op_tx,
+	.conf_tx	= acx_conf_tx,
+	.start		= acx_op_start,
+	.stop		= acx_op_stop,
+	.config		= acx_op_config,
+	.set_key	= acx_op_set_key,
+	.get_stats	= acx_op_get_stats,
+
+	.add_interface		= acx_op_add_interface,
+	.remove_interface	= acx_op_remove_interface,
+	.configure_filter	= acx_op_configure_filter,
+	.bss_info_changed	= acx_op_bss_info_changed,
+
+#if CONFIG_ACX_MAC80211_VERSION >= KERNEL_VERSION(3, 1, 0)
+	.hw_scan		= acx_op_hw_scan,
+#endif
+
+#if CONFIG_ACX_MAC80211_VERSION < KERNEL_VERSION(2, 6, 34)
+	.get_tx_stats = acx_e_op_get_tx_stats,
+#endif
+	.set_tim = acx_op_set_tim,
+};
+
+/*
+ * BOM Driver, Module
+ * ==================================================
+ */
+
+/* The slow part of acxsim_probe(), see acx_probe_async() */
+static int acxsim_probe_finish(acx_device_t *adev)
+{
+	struct ieee80211_hw *hw = adev->hw;
+	int err = -EIO;
+
+	if (acx_reset_on_probe(adev))
+		goto fail_reset_on_probe;
+
+	/* Debugfs */
+	if (acx_debugfs_add_adev(adev))
+		goto fail_debugfs;
+
+	/* Init ieee80211_hw  */
+	acx_init_ieee80211(adev, hw);
+	hw->wiphy->interface_modes =
+			BIT(NL80211_IFTYPE_STATION) |
+			BIT(NL80211_IFTYPE_ADHOC) |
+			BIT(NL80211_IFTYPE_AP);
+
+	if ((err = ieee80211_register_hw(hw))) {
+		pr_acx("ieee80211_register_hw() FAILED: %d\n", err);
+		goto fail_ieee80211_register_hw;
+	}
+
+	return OK;
+
+	/* error paths: undo everything in reverse order, the fw thread
+	 * and the image are left to acxsim_remove() */
+	fail_ieee80211_register_hw:
+	acx_debugfs_remove_adev(adev);
+
+	fail_debugfs:
+
+	fail_reset_on_probe:
+	acx_irq_disable(adev);
+
+	return err;
+}
+
+/*
+ * acxsim_probe
+ *
+ * Same sequence as acxpci_probe(), minus the PCI resources: the
+ * memory windows come from acxsim_alloc(), the irq is raised by the
+ * fw thread and the firmware image is made up.
+ */
+static int acxsim_probe(struct platform_device *pdev)
+{
+	acx_device_t *adev = NULL;
+	struct acxsim *sim;
+	struct ieee80211_hw *hw;
+	int result = -EIO;
+
+	/* Alloc ieee80211_hw  */
+	hw = acx_alloc_hw(&acxsim_hw_ops);
+	if (!hw)
+		goto fail_ieee80211_alloc_hw;
+	adev = hw2adev(hw);
+
+	/* Driver locking and queue mechanics */
+	if (acx_init_mechanics(adev))
+		goto fail_init_mechanics;
+
+	SET_IEEE80211_DEV(hw, &pdev->dev);
+	adev->bus_dev = &pdev->dev;
+	adev->dev_type = DEVTYPE_PCI;
+
+	platform_set_drvdata(pdev, hw);
+
+	sim = acxsim_alloc(pdev);
+	if (!sim) {
+		result = -ENOMEM;
+		goto fail_sim_alloc;
+	}
+	sim->adev = adev;
+	adev->sim = sim;
+
+	adev->chip_type = CHIPTYPE_ACX111;
+	adev->chip_name = "ACX111";
+	adev->io = IO_ACX111;
+	adev->iobase = (void __iomem *) sim->iobase;
+	adev->iobase2 = (void __iomem *) sim->iobase2;
+	adev->irq = 0;
+
+	pr_acx("simulated %s at %s\n", adev->chip_name, dev_name(&pdev->dev));
+	log(L_ANY, "the initial debug setting is 0x%04X\n", acx_debug);
+
+	/* Acx irqs shall be off and are enabled later in acx_up */
+	acx_irq_disable(adev);
+
+	acx_get_hardware_info(adev);
+
+	adev->fw_image = acx_fw_cache_add("acxsim", acxsim_fw_image(),
+					offsetof(firmware_image_t, data)
+					+ ACXSIM_FW_SIZE);
+	if (!adev->fw_image) {
+		result = -ENOMEM;
+		goto fail_fw_image;
+	}
+
+	sim->thread = kthread_run(acxsim_fw_thread, sim, "acxsim%d", pdev->id);
+	if (IS_ERR(sim->thread)) {
+		result = PTR_ERR(sim->thread);
+		goto fail_thread;
+	}
+
+	acx_probe_async(adev, acxsim_probe_finish);
+
+	result = OK;
+	goto done;
+
+	/* error paths: undo everything in reverse order... */
+	fail_thread:
+	acx_free_firmware(adev);
+
+	fail_fw_image:
+	adev->sim = NULL;
+	acxsim_free(sim);
+
+	fail_sim_alloc:
+	platform_set_drvdata(pdev, NULL);
+	acx_free_mechanics(adev);
+
+	fail_init_mechanics:
+	ieee80211_free_hw(hw);
+
+	fail_ieee80211_alloc_hw:
+
+	done:
+
+	return result;
+}
+
+static int acxsim_remove(struct platform_device *pdev)
+{
+	struct ieee80211_hw *hw = platform_get_drvdata(pdev);
+	acx_device_t *adev;
+	struct acxsim *sim;
+
+	if (!hw) {
+		log(L_DEBUG, "card is unused. Skipping any release code\n");
+		return 0;
+	}
+	adev = hw2adev(hw);
+	sim = adev->sim;
+
+	/* Unregister ieee80211 device, if acxsim_probe_finish() got
+	 * that far */
+	log(L_INIT, "removing device %s\n", wiphy_name(adev->hw->wiphy));
+	if (!acx_probe_wait(adev))
+		ieee80211_unregister_hw(adev->hw);
+
+	/* Disable both Tx and Rx to shut radio down properly */
+	if (test_bit(ACX_FLAG_HW_UP, &adev->flags)) {
+		acx_issue_cmd(adev, ACX1xx_CMD_DISABLE_TX, NULL, 0);
+		acx_issue_cmd(adev, ACX1xx_CMD_DISABLE_RX, NULL, 0);
+		clear_bit(ACX_FLAG_HW_UP, &adev->flags);
+	}
+	/* stop our eCPU */
+	acxpci_reset_mac(adev);
+
+	/* Debugfs */
+	acx_debugfs_remove_adev(adev);
+
+	/* IRQs */
+	acx_irq_disable(adev);
+
+	kthread_stop(sim->thread);
+
+	acx_free_firmware(adev);
+	acx_delete_dma_regions(adev);
+
+	platform_set_drvdata(pdev, NULL);
+
+	pr_acx("%s: cmds:%llu irqs:%llu tx:%llu (%llu bytes) rx:%llu "
+		"rx dropped:%llu\n", dev_name(&pdev->dev),
+		sim->stats.cmds, sim->stats.irqs, sim->stats.tx,
+		sim->stats.tx_bytes, sim->stats.rx, sim->stats.rx_dropped);
+	adev->sim = NULL;
+	acxsim_free(sim);
+
+	acx_free_mechanics(adev);
+	ieee80211_free_hw(adev->hw);
+
+	return 0;
+}
+
+static struct platform_driver acxsim_driver = {
+	.driver = {
+		.name = "acx-sim",
+	},
+	.probe = acxsim_probe,
+	.remove = acxsim_remove,
+};
+
+static struct platform_device *acxsim_devs[ACXSIM_MAX_DEVS];
+static int acxsim_driver_registered;
+
+/*
+ * acxsim_init_module
+ *
+ * Registers simdevs simulated devices. The default of none keeps the
+ * sim out of the way of real hardware.
+ */
+int __init acxsim_init_module(void)
+{
+	struct platform_device_info info = {
+		.name = "acx-sim",
+		.dma_mask = DMA_BIT_MASK(32),
+	};
+	unsigned int n = min_t(unsigned int, acx_sim_devs, ACXSIM_MAX_DEVS);
+	unsigned int i;
+	int res;
+
+	if (!n)
+		return -ENODEV;
+
+	res = platform_driver_register(&acxsim_driver);
+	if (res) {
+		pr_acx("platform_driver_register FAILED: %d\n", res);
+		return res;
+	}
+	acxsim_driver_registered = 1;
+
+	for (i = 0; i < n; i++) {
+		info.id = i;
+		acxsim_devs[i] = platform_device_register_full(&info);
+		if (IS_ERR(acxsim_devs[i])) {
+			res = PTR_ERR(acxsim_devs[i]);
+			acxsim_devs[i] = NULL;
+			pr_acx("registering simulated device %u FAILED: %d\n",
+				i, res);
+			break;
+		}
+	}
+
+	if (!i) {
+		platform_driver_unregister(&acxsim_driver);
+		acxsim_driver_registered = 0;
+		return res;
+	}
+
+	pr_acx("%u simulated device(s)\n", i);
+	return 0;
+}
+
+void __exit acxsim_cleanup_module(void)
+{
+	int i;
+
+	for (i = 0; i < ACXSIM_MAX_DEVS; i++) {
+		if (!acxsim_devs[i])
+			continue;
+		platform_device_unregister(acxsim_devs[i]);
+		acxsim_devs[i] = NULL;
+	}
+
+	if (acxsim_driver_registered)
+		platform_driver_unregister(&acxsim_driver);
+	acxsim_driver_registered = 0;
+}
@@ -0,0 +1,31 @@
+/* this file provides prototypes for functions defined in sim.c, the
+ * simulated acx111 device used to exercise the driver without
+ * hardware; it is part of the internal API.
+ */
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include "acx.h"
+
+#if defined(CONFIG_ACX_MAC80211_SIM)
+
+/* register access hooks, see read_reg32() & co in inlines.h */
+u32 acxsim_read_reg(acx_device_t *adev, unsigned int offset);
+void acxsim_write_reg(acx_device_t *adev, unsigned int offset, u32 val);
+
+int __init acxsim_init_module(void);
+void __exit acxsim_cleanup_module(void);
+
+#else /* !CONFIG_ACX_MAC80211_SIM */
+
+static inline u32 acxsim_read_reg(acx_device_t *adev, unsigned int offset)
+{ return 0; }
+static inline void acxsim_write_reg(acx_device_t *adev, unsigned int offset,
+				u32 val)
+{ }
+
+static inline int __init acxsim_init_module(void) { return -ENODEV; }
+static inline void __exit acxsim_cleanup_module(void) { }
+
+#endif /* CONFIG_ACX_MAC80211_SIM */
+#endif /* _SIM_H_ */
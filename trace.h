@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2003, 2004, 2005, 2006, 2007, 2008
+ * The ACX100 Open Source Project <acx100-devel@lists.sourceforge.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tracepoints, for perf and ftrace:
+ *
+ *   perf record -e 'acx:*' ...
+ *   echo 1 > /sys/kernel/debug/tracing/events/acx/enable
+ *
+ * Unlike log(), they cost next to nothing while disabled, so they can
+ * stay in the hot paths. The events are defined in trace.c.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM acx
+
+#if !defined(_ACX_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _ACX_TRACE_H_
+
+#include <linux/tracepoint.h>
+#include <linux/skbuff.h>
+#include <net/mac80211.h>
+
+#include "acx.h"
+
+/* The phy name identifies the device in every event */
+#define ACX_TRACE_DEV_ENTRY	__array(char, wiphy, 32)
+#define ACX_TRACE_DEV_ASSIGN	snprintf(__entry->wiphy, \
+					sizeof(__entry->wiphy), "%s", \
+					wiphy_name(adev->hw->wiphy))
+#define ACX_TRACE_DEV_PR_FMT	"%s"
+#define ACX_TRACE_DEV_PR_ARG	__entry->wiphy
+
+/* acx_op_tx(): frame from mac80211 */
+TRACE_EVENT(acx_tx_enqueue,
+	TP_PROTO(acx_device_t *adev, struct sk_buff *skb),
+	TP_ARGS(adev, skb),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(const void *, skb)
+		__field(unsigned int, len)
+		__field(unsigned int, backlog)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->skb = skb;
+		__entry->len = skb->len;
+		__entry->backlog = skb_queue_len(&adev->tx_queue);
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " skb=%p len=%u backlog=%u",
+		ACX_TRACE_DEV_PR_ARG, __entry->skb, __entry->len,
+		__entry->backlog)
+);
+
+/* acx_tx_frame(): frame handed to the hw queue */
+TRACE_EVENT(acx_tx_submit,
+	TP_PROTO(acx_device_t *adev, struct sk_buff *skb, int queue_id),
+	TP_ARGS(adev, skb, queue_id),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(const void *, skb)
+		__field(unsigned int, len)
+		__field(int, queue_id)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->skb = skb;
+		__entry->len = skb->len;
+		__entry->queue_id = queue_id;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " skb=%p len=%u queue=%d",
+		ACX_TRACE_DEV_PR_ARG, __entry->skb, __entry->len,
+		__entry->queue_id)
+);
+
+/* acx_tx_clean_txdesc(), usb: fw reported the frame done */
+TRACE_EVENT(acx_tx_status,
+	TP_PROTO(acx_device_t *adev, struct sk_buff *skb, int queue_id,
+		u8 error, u8 ack_failures),
+	TP_ARGS(adev, skb, queue_id, error, ack_failures),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(const void *, skb)
+		__field(int, queue_id)
+		__field(u8, error)
+		__field(u8, ack_failures)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->skb = skb;
+		__entry->queue_id = queue_id;
+		__entry->error = error;
+		__entry->ack_failures = ack_failures;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT
+		" skb=%p queue=%d error=0x%02x ack_failures=%u",
+		ACX_TRACE_DEV_PR_ARG, __entry->skb, __entry->queue_id,
+		__entry->error, __entry->ack_failures)
+);
+
+/* acx_rx(): frame handed to mac80211 */
+TRACE_EVENT(acx_rx,
+	TP_PROTO(acx_device_t *adev, struct sk_buff *skb, int signal),
+	TP_ARGS(adev, skb, signal),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(const void *, skb)
+		__field(unsigned int, len)
+		__field(int, signal)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->skb = skb;
+		__entry->len = skb->len;
+		__entry->signal = signal;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " skb=%p len=%u signal=%d",
+		ACX_TRACE_DEV_PR_ARG, __entry->skb, __entry->len,
+		__entry->signal)
+);
+
+/* acx_irq_work(): one pass over IO_ACX_IRQ_REASON */
+TRACE_EVENT(acx_irq,
+	TP_PROTO(acx_device_t *adev, u16 reason, u16 masked),
+	TP_ARGS(adev, reason, masked),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(u16, reason)
+		__field(u16, masked)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->reason = reason;
+		__entry->masked = masked;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " reason=0x%04x masked=0x%04x",
+		ACX_TRACE_DEV_PR_ARG, __entry->reason, __entry->masked)
+);
+
+/* _acx_issue_cmd_timeo_debug(): cmd triggered */
+TRACE_EVENT(acx_cmd_issue,
+	TP_PROTO(acx_device_t *adev, u16 cmd, u16 ie, unsigned int buflen),
+	TP_ARGS(adev, cmd, ie, buflen),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(u16, cmd)
+		__field(u16, ie)
+		__field(unsigned int, buflen)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->cmd = cmd;
+		__entry->ie = ie;
+		__entry->buflen = buflen;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " cmd=0x%02x ie=0x%04x buflen=%u",
+		ACX_TRACE_DEV_PR_ARG, __entry->cmd, __entry->ie,
+		__entry->buflen)
+);
+
+/* _acx_issue_cmd_timeo_debug(): cmd completed or timed out, status
+ * as in acx_cmd_status_str(), waited in ms */
+TRACE_EVENT(acx_cmd_done,
+	TP_PROTO(acx_device_t *adev, u16 cmd, u16 status, unsigned int waited),
+	TP_ARGS(adev, cmd, status, waited),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+		__field(u16, cmd)
+		__field(u16, status)
+		__field(unsigned int, waited)
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+		__entry->cmd = cmd;
+		__entry->status = status;
+		__entry->waited = waited;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT " cmd=0x%02x status=%u waited=%ums",
+		ACX_TRACE_DEV_PR_ARG, __entry->cmd, __entry->status,
+		__entry->waited)
+);
+
+/* acx_recover_hw() */
+TRACE_EVENT(acx_recover,
+	TP_PROTO(acx_device_t *adev),
+	TP_ARGS(adev),
+
+	TP_STRUCT__entry(
+		ACX_TRACE_DEV_ENTRY
+	),
+
+	TP_fast_assign(
+		ACX_TRACE_DEV_ASSIGN;
+	),
+
+	TP_printk(ACX_TRACE_DEV_PR_FMT, ACX_TRACE_DEV_PR_ARG)
+);
+
+#endif /* _ACX_TRACE_H_ */
+
+/* This part must be outside the include guard */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE trace
+#include <trace/define_trace.h>
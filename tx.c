@@ -24,17 +24,20 @@
 #include "merge.h"
 #include "usb.h"
 #include "main.h"
+#include "inlines.h"
 #include "tx.h"
+#include "bench.h"
+#include "trace.h"
 
 static int acx_is_hw_tx_queue_stop_limit(acx_device_t *adev)
 {
 	int i;
 	for (i=0; i<adev->num_hw_tx_queues; i++)
 	{
-		if (adev->hw_tx_queue[i].free < TX_STOP_QUEUE)
+		if (acx_tx_free(adev, i) < TX_STOP_QUEUE)
 		{
 			logf1(L_BUF, "Tx_free < TX_STOP_QUEUE (queue_id=%d: %u tx desc left):"
-				" Stop queue.\n", i, adev->hw_tx_queue[i].free);
+				" Stop queue.\n", i, acx_tx_free(adev, i));
 			return 1;
 		}
 	}
@@ -42,12 +45,38 @@ static int acx_is_hw_tx_queue_stop_limit(acx_device_t *adev)
 	return 0;
 }
 
-static void acx_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque)
+/*
+ * acx_tx_stop_queue
+ *
+ * Stops the queue once the hw tx ring runs low. Tx cleanup runs
+ * without the tx_lock, so it may have freed the ring meanwhile and
+ * seen the queue still running: check again after stopping.
+ */
+static void acx_tx_stop_queue(acx_device_t *adev)
 {
+	int i;
+
+	acx_stop_queue(adev->hw, NULL);
+
+	/* Pairs with the barrier in acx_irq_work() */
+	smp_mb();
+	for (i=0; i<adev->num_hw_tx_queues; i++)
+		if (acx_tx_free(adev, i) < TX_START_QUEUE)
+			return;
+
+	log(L_BUF, "tx: ring cleaned meanwhile, wake queue\n");
+	acx_wake_queue(adev->hw, NULL);
+	ieee80211_queue_work(adev->hw, &adev->tx_work);
+}
+
+static void acx_dealloc_tx(acx_device_t *adev, tx_t *tx_opaque, int q)
+{
+	if (IS_PCI(adev))
+		return acxpci_dealloc_tx(adev, tx_opaque, q);
 	if (IS_USB(adev))
-		acxusb_dealloc_tx(tx_opaque);
+		return acxusb_dealloc_tx(tx_opaque);
 	if (IS_MEM(adev))
-		acxmem_dealloc_tx (adev, tx_opaque);
+		return acxmem_dealloc_tx (adev, tx_opaque);
 
 	log(L_ANY, "Unsupported dev_type=%i\n", (adev)->dev_type);
 	return;
@@ -127,6 +156,16 @@ static int acx_tx_frame(acx_device_t *adev, struct sk_buff *skb)
 		return (-EBUSY);
 	}
 
+	/* PCI zero-copy: the hostdescs point into the mapped skb */
+	if (adev->hw_tx_queue[queue_id].zerocopy) {
+		if (unlikely(acx_tx_map_skb(adev, tx, skb, queue_id))) {
+			logf0(L_BUF, "skb dma mapping failed. Dropping skb.\n");
+			acx_dealloc_tx(adev, tx, queue_id);
+			return (-ENOMEM);
+		}
+		goto submit;
+	}
+
 	txbuf = acx_get_txbuf(adev, tx, queue_id);
 
 	if (unlikely(!txbuf)) {
@@ -135,7 +174,7 @@ static int acx_tx_frame(acx_device_t *adev, struct sk_buff *skb)
 			" Stop queue. Dealloc skb.\n");
 
 		/* OW only USB implemented */
-		acx_dealloc_tx(adev, tx);
+		acx_dealloc_tx(adev, tx, queue_id);
 		return (-ENXIO);
 	}
 
@@ -144,11 +183,14 @@ static int acx_tx_frame(acx_device_t *adev, struct sk_buff *skb)
 	 */
 	memcpy(txbuf, skb->data, skb->len);
 
-	acx_tx_data(adev, tx, skb->len, ctl, skb, queue_id);
-
+submit:
+	/* before handing it over, the skb may be gone right after */
+	trace_acx_tx_submit(adev, skb, queue_id);
 	adev->stats.tx_packets++;
 	adev->stats.tx_bytes += skb->len;
 
+	acx_tx_data(adev, tx, skb->len, ctl, skb, queue_id);
+
 	return 0;
 }
 
@@ -162,9 +204,13 @@ void acx_tx_queue_flush(acx_device_t *adev)
 
 		logf1(L_BUF, "Flushing skb 0x%p", skb);
 
+		if (acx_bench_tx_done(skb))
+			continue;
+
 		if (!(info->flags & IEEE80211_TX_CTL_REQ_TX_STATUS))
 			continue;
 
+		acx_tx_lat_clear(skb);
 		ieee80211_tx_status(adev->hw, skb);
 	}
 }
@@ -242,7 +288,7 @@ u16 acx111_tx_build_rateset(acx_device_t *adev, txacxdesc_t *txdesc,
 
 	u16 rateset = 0;
 
-	int debug = acx_debug & L_BUFT;
+	int debug = acx_debug_enabled(L_BUFT);
 
 	if (debug)
 		sprintf(tmpstr, "rates in info [bitrate,hw_value,count]: ");
@@ -289,7 +335,7 @@ void acx111_tx_build_txstatus(acx_device_t *adev,
 		}
 	}
 
-	if ((acx_debug & L_BUFT) && (ack_failures > 0)) {
+	if (acx_debug_enabled(L_BUFT) && (ack_failures > 0)) {
 
 		rate_bitrate = acx_rate111_hwvalue_to_bitrate(rate_hwvalue);
 		logf1(L_ANY,
@@ -341,7 +387,7 @@ void acxpcimem_handle_tx_error(acx_device_t *adev, u8 error,
 		    "too high or unable to Tx or Tx frame error - "
 		    "try changing 'iwconfig txpower XXX' or "
 		    "'sens'itivity or 'retry'";
-		log_level = acx_debug & L_DEBUG;
+		log_level = acx_debug_enabled(L_DEBUG);
 		/* adev->wstats.discard.retries++; */
 		/* Tx error 0x20 also seems to occur on
 		 * overheating, so I'm not sure whether we
@@ -472,24 +518,34 @@ void acx_tx_work(struct work_struct *work)
 {
 	acx_device_t *adev = container_of(work, struct acx_device, tx_work);
 
-	acx_sem_lock(adev);
-
+	/* No acx-sem: a long cmd (e.g. scan) must not hold up tx.
+	 * acx_tx_queue_go() takes the tx_lock. */
 	if (unlikely(!test_bit(ACX_FLAG_HW_UP, &adev->flags)))
-		goto out;
+		return;
 
 	acx_tx_queue_go(adev);
 
-	out:
-	acx_sem_unlock(adev);
-
 	return;
 }
 
 
+/*
+ * acx_tx_queue_go
+ *
+ * Submits queued frames until the tx queue is empty or the hw tx ring
+ * runs low. The whole batch is filled under one acxmem_lock, and PCI
+ * and mem adapters get a single INT_TRIG_TXPRC at the end instead of
+ * one per frame.
+ */
 void acx_tx_queue_go(acx_device_t *adev)
 {
 	struct sk_buff *skb;
 	int ret;
+	int submitted = 0;
+	acxmem_lock_flags;
+
+	acx_tx_lock(adev);
+	acxmem_lock();
 
 	while ((skb = skb_dequeue(&adev->tx_queue))) {
 
@@ -497,29 +553,79 @@ void acx_tx_queue_go(acx_device_t *adev)
 
 		if (ret == -EBUSY) {
 			logf0(L_BUFT, "EBUSY: Stop queue. Requeuing skb.\n");
-			acx_stop_queue(adev->hw, NULL);
 			skb_queue_head(&adev->tx_queue, skb);
+			acx_tx_stop_queue(adev);
 			goto out;
+		} else if (ret == -ENOMEM) {
+			/* transient, keep the queue running */
+			dev_kfree_skb_any(skb);
+			continue;
 		} else if (ret < 0) {
 			logf0(L_BUF, "Other ERR: (Card was removed ?!):"
 				" Stop queue. Dealloc skb.\n");
 			acx_stop_queue(adev->hw, NULL);
-			dev_kfree_skb(skb);
+			dev_kfree_skb_any(skb);
 			goto out;
 		}
+		submitted++;
 
 		/* Keep a few free descs between head and tail of tx
 		 * ring. It is not absolutely needed, just feels
 		 * safer */
 		if (acx_is_hw_tx_queue_stop_limit(adev))
 		{
-			acx_stop_queue(adev->hw, NULL);
+			acx_tx_stop_queue(adev);
 			goto out;
 		}
 	}
 out:
+	if (submitted && (IS_PCI(adev) || IS_MEM(adev))) {
+		log(L_BUFT, "tx: kick after %d frames\n", submitted);
+		acx_tx_kick(adev);
+	}
+
+	acxmem_unlock();
+	acx_tx_unlock(adev);
 	return;
 }
 
+/*
+ * acx_tx_fast
+ *
+ * PCI fast path for acx_op_tx(): submit the frame right away if
+ * nothing is queued ahead of it and the hw ring has room, saving the
+ * tx_work round trip. Returns 0 if the frame was taken, anything else
+ * means the caller has to queue it for tx_work.
+ */
+int acx_tx_fast(acx_device_t *adev, struct sk_buff *skb)
+{
+	int ret = -EBUSY;
+
+	if (!IS_PCI(adev))
+		return ret;
+
+	acx_tx_lock(adev);
+
+	if (unlikely(!test_bit(ACX_FLAG_HW_UP, &adev->flags)))
+		goto out;
+
+	/* keep ordering with frames already waiting for tx_work */
+	if (!skb_queue_empty(&adev->tx_queue)
+		|| acx_is_hw_tx_queue_stop_limit(adev))
+		goto out;
+
+	ret = acx_tx_frame(adev, skb);
+	if (ret)
+		goto out;
+
+	acx_tx_kick(adev);
+
+	if (acx_is_hw_tx_queue_stop_limit(adev))
+		acx_tx_stop_queue(adev);
+out:
+	acx_tx_unlock(adev);
+	return ret;
+}
+
 
 
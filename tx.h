@@ -20,5 +20,6 @@ void acxpcimem_handle_tx_error(acx_device_t *adev, u8 error,
 
 void acx_tx_work(struct work_struct *work);
 void acx_tx_queue_go(acx_device_t *adev);
+int acx_tx_fast(acx_device_t *adev, struct sk_buff *skb);
 
 #endif
@@ -64,6 +64,9 @@
 #include "tx.h"
 #include "main.h"
 #include "boot.h"
+#include "bench.h"
+#include "trace.h"
+#include "inlines.h"
 
 /* OW, 20091205, TODO, Info on TNETW1450 support:
  * Firmware loads, device shows activity, however RX and TX paths are broken.
@@ -214,7 +217,7 @@ static void acxusb_read_eeprom_version(acx_device_t * adev)
 }
 
 static inline
-int acxusb_fw_needs_padding(firmware_image_t *fw_image,
+int acxusb_fw_needs_padding(const firmware_image_t *fw_image,
 			unsigned int usb_maxlen)
 {
 	unsigned int num_xfers = ((fw_image->size - 1) / usb_maxlen) + 1;
@@ -239,7 +242,7 @@ acxusb_boot(struct usb_device *usbdev, int is_tnetw1450, int *radio_type)
 {
 	char filename[sizeof("tiacx1NNusbcRR")];
 
-	firmware_image_t *fw_image = NULL;
+	const firmware_image_t *fw_image = NULL;
 	char *usbbuf;
 	unsigned int offset;
 	unsigned int blk_len, inpipe, outpipe;
@@ -356,7 +359,7 @@ acxusb_boot(struct usb_device *usbdev, int is_tnetw1450, int *radio_type)
 			log(L_INIT,
 			    "acx: uploading firmware (%d bytes, offset=%d)\n",
 			    blk_len, offset);
-			memcpy(usbbuf, ((u8 *) fw_image) + offset, blk_len);
+			memcpy(usbbuf, ((const u8 *) fw_image) + offset, blk_len);
 
 			p = usbbuf;
 			for (i = 0; i < blk_len; i += 4) {
@@ -437,7 +440,7 @@ acxusb_boot(struct usb_device *usbdev, int is_tnetw1450, int *radio_type)
 			log(L_INIT,
 			    "acx: uploading firmware (%d bytes, offset=%d)\n",
 			    blk_len, offset);
-			memcpy(usbbuf, ((u8 *) fw_image) + offset, blk_len);
+			memcpy(usbbuf, ((const u8 *) fw_image) + offset, blk_len);
 			result = usb_control_msg(usbdev, outpipe, ACX_USB_REQ_UPLOAD_FW, USB_TYPE_VENDOR | USB_DIR_OUT, (file_size - 8) & 0xffff,	/* value */
 						 (file_size - 8) >> 16,	/* index */
 						 usbbuf,	/* dataptr */
@@ -485,7 +488,7 @@ acxusb_boot(struct usb_device *usbdev, int is_tnetw1450, int *radio_type)
 	}
 
       end:
-	vfree(fw_image);
+	acx_release_fw(fw_image);
 	kfree(usbbuf);
 
 
@@ -584,7 +587,7 @@ acxusb_issue_cmd_timeo_debug(acx_device_t * adev,
 	inpipe = usb_rcvctrlpipe(usbdev, 0);
 	log(L_CTL, "trl inpipe=0x%X outpipe=0x%X\n", inpipe, outpipe);
 	log(L_CTL, "sending USB control msg (out) (blocklen=%d)\n", blocklen);
-	if (acx_debug & L_DATA)
+	if (acx_debug_enabled(L_DATA))
 		acx_dump_bytes(loc, blocklen);
 
 	result = usb_control_msg(usbdev, outpipe, ACX_USB_REQ_CMD,	/* request */
@@ -622,7 +625,7 @@ acxusb_issue_cmd_timeo_debug(acx_device_t * adev,
 		pr_acx("%s: USB read error %d\n", devname, result);
 		goto bad;
 	}
-	if (acx_debug & L_CTL) {
+	if (acx_debug_enabled(L_CTL)) {
 		pr_acx("read %d bytes: ", result);
 		acx_dump_bytes(loc, result);
 	}
@@ -913,7 +916,7 @@ static void acxusb_complete_rx(struct urb *urb)
 		ptr = &adev->rxtruncbuf;
 		packetsize = RXBUF_BYTES_USED(ptr);
 
-		if (acx_debug & (L_USBRXTX)) {
+		if (acx_debug_enabled(L_USBRXTX)) {
 			pr_acx("handling truncated frame (truncsize=%d, size=%d, "
 			       "packetsize(from trunc)=%d)\n",
 			       adev->rxtruncsize, size, packetsize);
@@ -944,7 +947,7 @@ static void acxusb_complete_rx(struct urb *urb)
 			memcpy(((char *)ptr) + adev->rxtruncsize, inbuf,
 			       tail_size);
 
-			if (acx_debug & (L_USBRXTX)) {
+			if (acx_debug_enabled(L_USBRXTX)) {
 				pr_acxusb("full trailing packet + 12 bytes:\n");
 				acx_dump_bytes(inbuf, tail_size + RXBUF_HDRSIZE);
 			}
@@ -953,7 +956,7 @@ static void acxusb_complete_rx(struct urb *urb)
 			ptr = (rxbuffer_t *) (((char *)inbuf) + tail_size);
 			remsize -= tail_size;
 		}
-		if (acx_debug & (L_USBRXTX))
+		if (acx_debug_enabled(L_USBRXTX))
 				pr_acxusb("post-merge size=%d remsize=%d\n", size, remsize);
 	}
 
@@ -1001,14 +1004,17 @@ static void acxusb_complete_rx(struct urb *urb)
 		txstatus->status.rates[0].count = stat->ack_failures + 1;
 
 		// report upstream
-		ieee80211_tx_status(adev->hw, skb);
+		trace_acx_tx_status(adev, skb, 0, stat->mac_status,
+				stat->ack_failures);
+		if (!acx_bench_tx_done(skb))
+			ieee80211_tx_status(adev->hw, skb);
 
 		tx->busy = 0;
-		adev->hw_tx_queue[0].free++;
+		acx_tx_cleaned(adev, 0, 1);
 
-		if ((adev->hw_tx_queue[0].free >= TX_START_QUEUE) && acx_queue_stopped(adev->hw)) {
+		if ((acx_tx_free(adev, 0) >= TX_START_QUEUE) && acx_queue_stopped(adev->hw)) {
 			log(L_BUF, "tx: wake queue (avail. Tx desc %u)\n",
-				adev->hw_tx_queue[0].free);
+				acx_tx_free(adev, 0));
 			acx_wake_queue(adev->hw, NULL);
 			ieee80211_queue_work(adev->hw, &adev->tx_work);
 		}
@@ -1028,7 +1034,7 @@ static void acxusb_complete_rx(struct urb *urb)
 
 		if (packetsize > remsize) {
 			/* frame truncation handling */
-			if (acx_debug & (L_USBRXTX)) {
+			if (acx_debug_enabled(L_USBRXTX)) {
 				pr_acxusb("need to truncate packet, "
 				       "packetsize=%d remsize=%d "
 				       "size=%d bytes:",
@@ -1047,7 +1053,7 @@ static void acxusb_complete_rx(struct urb *urb)
 		next:
 		ptr = (rxbuffer_t *) (((char *)ptr) + packetsize);
 		remsize -= packetsize;
-		if ((acx_debug & (L_USBRXTX)) && remsize) {
+		if (acx_debug_enabled(L_USBRXTX) && remsize) {
 			pr_acx("more than one packet in buffer, "
 			       "second packet hdr:");
 			acx_dump_bytes(ptr, RXBUF_HDRSIZE);
@@ -1169,6 +1175,14 @@ static void acxusb_complete_tx(struct urb *urb)
 
 }
 
+/* The urbs are the usb "tx ring", see acx_tx_free() */
+static void acxusb_reset_tx_queue(acx_device_t *adev)
+{
+	adev->tx_cnt = ACX_TX_URB_CNT;
+	adev->hw_tx_queue[0].queued = 0;
+	adev->hw_tx_queue[0].cleaned = 0;
+}
+
 /*
  * acxusb_alloc_tx
  * Actually returns a usb_tx_t* ptr
@@ -1188,7 +1202,6 @@ tx_t *acxusb_alloc_tx(acx_device_t *adev)
 				"acx: allocated tx %d\n", head);
 			tx = &adev->usb_tx[head];
 			tx->busy = 1;
-			adev->hw_tx_queue[0].free--;
 			goto end;
 		}
 	} while (likely(head != adev->hw_tx_queue[0].head));
@@ -1247,7 +1260,7 @@ void acxusb_tx_data(acx_device_t *adev, tx_t *tx_opaque, int wlanpkt_len,
 	txnum = tx - adev->usb_tx;
 
 	log(L_DEBUG, "using buf#%d free=%d len=%d\n",
-	    txnum, adev->hw_tx_queue[0].free, wlanpkt_len);
+	    txnum, acx_tx_free(adev, 0), wlanpkt_len);
 
 	/* fill the USB transfer header */
 	txbuf->desc = cpu_to_le16(USB_TXBUF_TXDESC);
@@ -1266,7 +1279,7 @@ void acxusb_tx_data(acx_device_t *adev, tx_t *tx_opaque, int wlanpkt_len,
 	txbuf->ctrl2 = 0;
 	txbuf->data_len = cpu_to_le16(wlanpkt_len);
 
-	if (unlikely(acx_debug & L_DATA)) {
+	if (unlikely(acx_debug_enabled(L_DATA))) {
 		pr_acx("dump of bulk out urb:\n");
 		acx_dump_bytes(txbuf, wlanpkt_len + USB_TXBUF_HDRSIZE);
 	}
@@ -1286,6 +1299,8 @@ void acxusb_tx_data(acx_device_t *adev, tx_t *tx_opaque, int wlanpkt_len,
 	    );
 
 	txurb->transfer_flags = URB_ASYNC_UNLINK | URB_ZERO_PACKET;
+	/* account before submitting, the completion may run right away */
+	acx_tx_queued(adev, 0);
 	ucode = usb_submit_urb(txurb, GFP_ATOMIC);
 	log(L_USBRXTX, "SUBMIT TX (%d): outpipe=0x%X buf=%p txsize=%d "
 	    "rate=%u errcode=%d\n", txnum, outpipe, txbuf,
@@ -1300,7 +1315,8 @@ void acxusb_tx_data(acx_device_t *adev, tx_t *tx_opaque, int wlanpkt_len,
 		 */
 		adev->stats.tx_errors++;
 		tx->busy = 0;
-		adev->hw_tx_queue[0].free++;
+		/* never completes, take it back */
+		adev->hw_tx_queue[0].queued--;
 		/* needed? if (adev->tx_free > TX_START_QUEUE) acx_wake_queue(...) */
 	}
 
@@ -1419,7 +1435,7 @@ static int acxusb_op_start(struct ieee80211_hw *hw)
 		adev->usb_tx[i].urb->status = 0;
 		adev->usb_tx[i].busy = 0;
 	}
-	adev->hw_tx_queue[0].free = ACX_TX_URB_CNT;
+	acxusb_reset_tx_queue(adev);
 
 	/* put the ACX100 out of sleep mode */
 	acx_issue_cmd(adev, ACX1xx_CMD_WAKE, NULL, 0);
@@ -1482,7 +1498,7 @@ static void acxusb_op_stop(struct ieee80211_hw *hw)
 		acxusb_unlink_urb(adev->usb_rx[i].urb);
 		adev->usb_rx[i].busy = 0;
 	}
-	adev->hw_tx_queue[0].free = ACX_TX_URB_CNT;
+	acxusb_reset_tx_queue(adev);
 
 	adev->channel = 1;
 
@@ -1527,6 +1543,62 @@ static const struct ieee80211_ops acxusb_hw_ops = {
  * ==================================================
  */
 
+/*
+ * acxusb_probe_finish()
+ *
+ * The slow part of acxusb_probe() on a booted device, see
+ * acx_probe_async(). Booting an unbooted one stays in acxusb_probe(),
+ * there is no device to finish until it re-enumerates.
+ */
+static int acxusb_probe_finish(acx_device_t *adev)
+{
+	struct ieee80211_hw *hw = adev->hw;
+	int result;
+
+	/* TODO: move all of fw cmds to open()? But then we won't know our MAC addr
+	   until ifup (it's available via reading ACX1xx_IE_DOT11_STATION_ID)... */
+
+	/* put acx out of sleep mode and initialize it */
+	acx_issue_cmd(adev, ACX1xx_CMD_WAKE, NULL, 0);
+
+	result = acx_init_mac(adev);
+	if (result)
+		return result;
+
+	/* TODO: see similar code in pci.c */
+	acxusb_read_eeprom_version(adev);
+	acxusb_fill_configoption(adev);
+	acx_set_defaults(adev);
+	acx_get_firmware_version(adev);
+	acx_display_hardware_details(adev);
+
+	acx1xx_get_station_id(adev);
+	SET_IEEE80211_PERM_ADDR(adev->hw, adev->dev_addr);
+
+	// Debug and proc-fs
+	acx_debugfs_add_adev(adev);
+
+	/* Init ieee80211_hw  */
+	acx_init_ieee80211(adev, hw);
+	hw->wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION)
+	        | BIT(NL80211_IFTYPE_ADHOC);
+
+	if ((result = ieee80211_register_hw(adev->hw))) {
+		pr_acx("failed to register USB network device (error %d)\n",
+			result);
+		acx_debugfs_remove_adev(adev);
+		return result;
+	}
+
+	pr_acx("USB module loaded successfully\n");
+
+#if CMD_DISCOVERY
+	great_inquisitor(adev);
+#endif
+
+	return OK;
+}
+
 /*
  * acxusb_probe()
  *
@@ -1710,47 +1782,10 @@ acxusb_probe(struct usb_interface *intf, const struct usb_device_id *devID)
 		adev->usb_tx[i].adev = adev;
 		adev->usb_tx[i].busy = 0;
 	}
-	adev->hw_tx_queue[0].free = ACX_TX_URB_CNT;
-
-	/* TODO: move all of fw cmds to open()? But then we won't know our MAC addr
-	   until ifup (it's available via reading ACX1xx_IE_DOT11_STATION_ID)... */
-
-	/* put acx out of sleep mode and initialize it */
-	acx_issue_cmd(adev, ACX1xx_CMD_WAKE, NULL, 0);
+	acxusb_reset_tx_queue(adev);
 
-	result = acx_init_mac(adev);
-	if (result)
-		goto end;
-
-	/* TODO: see similar code in pci.c */
-	acxusb_read_eeprom_version(adev);
-	acxusb_fill_configoption(adev);
-	acx_set_defaults(adev);
-	acx_get_firmware_version(adev);
-	acx_display_hardware_details(adev);
-
-	acx1xx_get_station_id(adev);
-	SET_IEEE80211_PERM_ADDR(adev->hw, adev->dev_addr);
-
-	// Debug and proc-fs
-	acx_debugfs_add_adev(adev);
-
-	/* Init ieee80211_hw  */
-	acx_init_ieee80211(adev, hw);
-	hw->wiphy->interface_modes = BIT(NL80211_IFTYPE_STATION)
-	        | BIT(NL80211_IFTYPE_ADHOC);
-
-	if ((result = ieee80211_register_hw(adev->hw))) {
-		msg = "acx: failed to register USB network device "
-		    "(error %d)\n";
-		goto end_nomem;
-	}
-
-	pr_acx("USB module loaded successfully\n");
-
-#if CMD_DISCOVERY
-	great_inquisitor(adev);
-#endif
+	/* The fw cmds are left to acxusb_probe_finish() */
+	acx_probe_async(adev, acxusb_probe_finish);
 
 	/* Everything went OK, we are happy now */
 	result = OK;
@@ -1813,8 +1848,11 @@ static void acxusb_disconnect(struct usb_interface *intf)
 	 * This can't be called with sem or lock held because
 	 * _close() will try to grab it as well if it's called,
 	 * deadlocking the machine.
+	 *
+	 * Only if acxusb_probe_finish() got that far.
 	 */
-	ieee80211_unregister_hw(adev->hw);
+	if (!acx_probe_wait(adev))
+		ieee80211_unregister_hw(adev->hw);
 
 	acx_debugfs_remove_adev(adev);
 
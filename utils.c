@@ -35,7 +35,7 @@ void acx_print_mac2(const char *head, const u8 *mac, const char *tail)
 
 void acxlog_mac(int level, const char *head, const u8 *mac, const char *tail)
 {
-	if (acx_debug & level)
+	if (acx_debug_enabled(level))
 		acx_print_mac2(head, mac, tail);
 }
 